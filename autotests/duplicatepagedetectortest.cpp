@@ -0,0 +1,144 @@
+/*
+ * SPDX-FileCopyrightText: 2026 KSaneCore developers
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+ */
+
+#include <QTest>
+
+#include "duplicatepagedetector.h"
+
+using namespace KSaneCore;
+
+class DuplicatePageDetectorTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void disabled();
+    void exactDuplicate();
+    void perceptualDistance_data();
+    void perceptualDistance();
+    void recentPages();
+    void blankPages();
+
+private:
+    static QVariantMap page(const QString &sha256, quint64 perceptualHash, bool blank = false);
+};
+
+QVariantMap DuplicatePageDetectorTest::page(const QString &sha256, quint64 perceptualHash, bool blank)
+{
+    QVariantMap metadata;
+    metadata[QStringLiteral("sha256")] = sha256;
+    metadata[QStringLiteral("perceptualHash")] = perceptualHash;
+    metadata[QStringLiteral("blankPage")] = blank;
+    return metadata;
+}
+
+void DuplicatePageDetectorTest::disabled()
+{
+    DuplicatePageDetector detector;
+    QVERIFY(!detector.isEnabled());
+    QVariantMap metadata = page(QStringLiteral("a"), 1);
+    QCOMPARE(detector.markPage(metadata), 0);
+    metadata = page(QStringLiteral("a"), 1);
+    QCOMPARE(detector.markPage(metadata), 0);
+    QVERIFY(!metadata.contains(QStringLiteral("duplicatePage")));
+
+    detector.setDetection(-1, 4);
+    QVERIFY(!detector.isEnabled());
+}
+
+void DuplicatePageDetectorTest::exactDuplicate()
+{
+    DuplicatePageDetector detector;
+    detector.setDetection(3, 0);
+    QVERIFY(detector.isEnabled());
+
+    QVariantMap metadata = page(QStringLiteral("a"), 0x0F0F);
+    QCOMPARE(detector.markPage(metadata), 0);
+    QCOMPARE(metadata.value(QStringLiteral("duplicatePage")).toInt(), 0);
+    QCOMPARE(metadata.value(QStringLiteral("exactDuplicate")).toBool(), false);
+
+    // identical image data is a duplicate even if the perceptual hashes differ
+    metadata = page(QStringLiteral("a"), 0xF0F0);
+    QCOMPARE(detector.markPage(metadata), 1);
+    QCOMPARE(metadata.value(QStringLiteral("duplicatePage")).toInt(), 1);
+    QCOMPARE(metadata.value(QStringLiteral("exactDuplicate")).toBool(), true);
+}
+
+void DuplicatePageDetectorTest::perceptualDistance_data()
+{
+    QTest::addColumn<quint64>("perceptualHash");
+    QTest::addColumn<int>("duplicatePage");
+
+    QTest::newRow("same") << quint64(0xFF00FF00) << 1;
+    QTest::newRow("maximum distance") << quint64(0xFF00FF0F) << 1;
+    QTest::newRow("above maximum distance") << quint64(0xFF00FF1F) << 0;
+    QTest::newRow("inverted") << ~quint64(0xFF00FF00) << 0;
+}
+
+void DuplicatePageDetectorTest::perceptualDistance()
+{
+    QFETCH(quint64, perceptualHash);
+    QFETCH(int, duplicatePage);
+
+    DuplicatePageDetector detector;
+    detector.setDetection(1, 4);
+    QVariantMap metadata = page(QStringLiteral("a"), 0xFF00FF00);
+    detector.markPage(metadata);
+
+    metadata = page(QStringLiteral("b"), perceptualHash);
+    QCOMPARE(detector.markPage(metadata), duplicatePage);
+    QCOMPARE(metadata.value(QStringLiteral("duplicatePage")).toInt(), duplicatePage);
+    QCOMPARE(metadata.value(QStringLiteral("exactDuplicate")).toBool(), false);
+}
+
+void DuplicatePageDetectorTest::recentPages()
+{
+    DuplicatePageDetector detector;
+    detector.setDetection(2, 0);
+    const QList<quint64> hashes = {0x1, 0x3, 0x7};
+    for (int i = 0; i < hashes.size(); i++) {
+        QVariantMap metadata = page(QString::number(i), hashes.at(i));
+        QCOMPARE(detector.markPage(metadata), 0);
+    }
+
+    // the number of pages before the current one, the most recent match counts
+    QVariantMap metadata = page(QStringLiteral("x"), 0x3);
+    QCOMPARE(detector.markPage(metadata), 2);
+    metadata = page(QStringLiteral("y"), 0x3);
+    QCOMPARE(detector.markPage(metadata), 1);
+    // only the last two pages are compared
+    metadata = page(QStringLiteral("z"), 0x7);
+    QCOMPARE(detector.markPage(metadata), 0);
+
+    // changing the detection forgets the previous pages
+    detector.setDetection(2, 0);
+    metadata = page(QStringLiteral("z"), 0x7);
+    QCOMPARE(detector.markPage(metadata), 0);
+}
+
+void DuplicatePageDetectorTest::blankPages()
+{
+    DuplicatePageDetector detector;
+    detector.setDetection(3, 4);
+
+    // blank pages are neither marked nor remembered
+    QVariantMap metadata = page(QStringLiteral("blank"), 0, true);
+    QCOMPARE(detector.markPage(metadata), 0);
+    metadata = page(QStringLiteral("blank"), 0, true);
+    QCOMPARE(detector.markPage(metadata), 0);
+    QVERIFY(!metadata.contains(QStringLiteral("duplicatePage")));
+    metadata = page(QStringLiteral("blank"), 0);
+    QCOMPARE(detector.markPage(metadata), 0);
+
+    // pages without hashes are not compared
+    metadata.clear();
+    QCOMPARE(detector.markPage(metadata), 0);
+    QVERIFY(metadata.isEmpty());
+}
+
+QTEST_GUILESS_MAIN(DuplicatePageDetectorTest)
+
+#include "duplicatepagedetectortest.moc"
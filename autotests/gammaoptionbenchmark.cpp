@@ -0,0 +1,124 @@
+/*
+ * SPDX-FileCopyrightText: 2026 KSaneCore developers
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+ */
+
+#include <QTest>
+
+#include "gammaoption.h"
+
+using namespace KSaneCore;
+
+/* A gamma option with a descriptor like the one of a device. The option is
+ * not selectable by software, so the tables are never written to a device. */
+class TestGammaOption : public GammaOption
+{
+public:
+    explicit TestGammaOption(int size)
+        : GammaOption(nullptr, 0)
+    {
+        m_range.min = 0;
+        m_range.max = size - 1;
+        m_range.quant = 0;
+        m_descriptor.name = "gamma-table";
+        m_descriptor.type = SANE_TYPE_INT;
+        m_descriptor.unit = SANE_UNIT_NONE;
+        m_descriptor.size = size * sizeof(SANE_Word);
+        m_descriptor.cap = SANE_CAP_SOFT_DETECT;
+        m_descriptor.constraint_type = SANE_CONSTRAINT_RANGE;
+        m_descriptor.constraint.range = &m_range;
+        m_optDesc = &m_descriptor;
+        applyValueData(deviceData(0, 0, 100, size));
+    }
+
+    /* The raw data of a table like a device would return it */
+    static QByteArray deviceData(int brightness, int contrast, int gamma, int size)
+    {
+        const QVector<int> table = gammaTable(brightness, contrast, gamma, size, size - 1);
+        QByteArray data(size * sizeof(SANE_Word), 0);
+        SANE_Word *words = reinterpret_cast<SANE_Word *>(data.data());
+        for (int i = 0; i < size; i++) {
+            words[i] = table[i];
+        }
+        return data;
+    }
+
+private:
+    SANE_Range m_range;
+    SANE_Option_Descriptor m_descriptor = {};
+};
+
+class GammaOptionBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void calculateTable_data();
+    void calculateTable();
+    void fitTable_data();
+    void fitTable();
+};
+
+void GammaOptionBenchmark::calculateTable_data()
+{
+    QTest::addColumn<int>("size");
+    QTest::addColumn<bool>("changeGamma");
+
+    QTest::newRow("4096 entries, brightness") << 4096 << false;
+    QTest::newRow("4096 entries, gamma") << 4096 << true;
+    QTest::newRow("65536 entries, brightness") << 65536 << false;
+    QTest::newRow("65536 entries, gamma") << 65536 << true;
+}
+
+void GammaOptionBenchmark::calculateTable()
+{
+    QFETCH(int, size);
+    QFETCH(bool, changeGamma);
+
+    TestGammaOption option(size);
+    int step = 0;
+    // every step is a new value like while dragging a slider
+    QBENCHMARK {
+        step = (step + 1) % 50;
+        QVariantList value = {step, 0, 100};
+        if (changeGamma) {
+            value = {0, 0, 100 + step};
+        }
+        QVERIFY(option.setValue(value));
+    }
+}
+
+void GammaOptionBenchmark::fitTable_data()
+{
+    QTest::addColumn<int>("size");
+
+    QTest::newRow("4096 entries") << 4096;
+    QTest::newRow("65536 entries") << 65536;
+}
+
+void GammaOptionBenchmark::fitTable()
+{
+    QFETCH(int, size);
+
+    TestGammaOption option(size);
+    // alternate the tables, an unchanged table is not fitted again
+    const QByteArray tables[2] = {TestGammaOption::deviceData(10, 20, 150, size), TestGammaOption::deviceData(-15, 10, 70, size)};
+    int step = 0;
+    QBENCHMARK {
+        step = 1 - step;
+        option.applyValueData(tables[step]);
+    }
+
+    option.applyValueData(tables[0]);
+    const QVariantList value = option.value().toList();
+    QCOMPARE(value.size(), 3);
+    // the fit is exact up to the rounding of the table
+    QVERIFY(qAbs(value.at(0).toInt() - 10) <= 1);
+    QVERIFY(qAbs(value.at(1).toInt() - 20) <= 1);
+    QVERIFY(qAbs(value.at(2).toInt() - 150) <= 1);
+}
+
+QTEST_GUILESS_MAIN(GammaOptionBenchmark)
+
+#include "gammaoptionbenchmark.moc"
@@ -0,0 +1,188 @@
+/*
+ * SPDX-FileCopyrightText: 2026 KSaneCore developers
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+ */
+
+#include <QImage>
+#include <QTest>
+
+#include "imagebuilder.h"
+
+using namespace KSaneCore;
+
+class ImageBuilderTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void reduceGray();
+    void reduceColor();
+    void reduceMono();
+    void changedFactors();
+
+private:
+    static SANE_Parameters parameters(SANE_Frame format, int depth, int width, int height);
+    static void copyRows(ImageBuilder &builder, const QByteArray &data, int bytesPerLine, int firstRow, int endRow);
+    static void compareReduction(const QImage &image, const QImage &reduced, int factor);
+};
+
+SANE_Parameters ImageBuilderTest::parameters(SANE_Frame format, int depth, int width, int height)
+{
+    SANE_Parameters params;
+    params.format = format;
+    params.last_frame = SANE_TRUE;
+    params.pixels_per_line = width;
+    params.lines = height;
+    params.depth = depth;
+    params.bytes_per_line = format == SANE_FRAME_RGB ? width * 3 : (width * depth + 7) / 8;
+    return params;
+}
+
+void ImageBuilderTest::copyRows(ImageBuilder &builder, const QByteArray &data, int bytesPerLine, int firstRow, int endRow)
+{
+    // the rows arrive one at a time like from a slow scanner
+    for (int y = firstRow; y < endRow; y++) {
+        QVERIFY(builder.copyToImage(reinterpret_cast<const SANE_Byte *>(data.constData()) + y * bytesPerLine, bytesPerLine));
+    }
+}
+
+void ImageBuilderTest::compareReduction(const QImage &image, const QImage &reduced, int factor)
+{
+    QCOMPARE(reduced.width(), (image.width() + factor - 1) / factor);
+    QCOMPARE(reduced.height(), (image.height() + factor - 1) / factor);
+    QCOMPARE(reduced.dotsPerMeterX(), image.dotsPerMeterX() / factor);
+    QCOMPARE(reduced.dotsPerMeterY(), image.dotsPerMeterY() / factor);
+
+    // the blocks at the right and bottom edges are smaller
+    for (int blockY = 0; blockY < reduced.height(); blockY++) {
+        for (int blockX = 0; blockX < reduced.width(); blockX++) {
+            int red = 0;
+            int green = 0;
+            int blue = 0;
+            int count = 0;
+            for (int y = blockY * factor; y < qMin((blockY + 1) * factor, image.height()); y++) {
+                for (int x = blockX * factor; x < qMin((blockX + 1) * factor, image.width()); x++) {
+                    const QRgb pixel = image.pixel(x, y);
+                    red += qRed(pixel);
+                    green += qGreen(pixel);
+                    blue += qBlue(pixel);
+                    count++;
+                }
+            }
+            QCOMPARE(reduced.pixel(blockX, blockY), qRgb(red / count, green / count, blue / count));
+        }
+    }
+}
+
+void ImageBuilderTest::reduceGray()
+{
+    const int width = 10;
+    const int height = 7;
+    QByteArray data(width * height, 0);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            data[y * width + x] = static_cast<char>((x * 20 + y * 3) & 0xFF);
+        }
+    }
+
+    QImage image;
+    int dpi = 300;
+    ImageBuilder builder(&image, &dpi);
+    // a factor of 1 would only copy the image
+    builder.setReductionFactors({1, 2, 3});
+    builder.start(parameters(SANE_FRAME_GRAY, 8, width, height));
+    QCOMPARE(builder.reducedImages().size(), 2);
+    QCOMPARE(builder.reducedImages().at(0).format(), QImage::Format_Grayscale8);
+
+    // a band is reduced as soon as its rows are complete
+    copyRows(builder, data, width, 0, 3);
+    const QImage band = builder.reducedImages().at(1);
+    QCOMPARE(band.pixel(0, 0), qRgb(23, 23, 23));
+    QCOMPARE(band.pixel(0, 1), qRgb(0xFF, 0xFF, 0xFF));
+
+    copyRows(builder, data, width, 3, height);
+    builder.finish();
+    compareReduction(image, builder.reducedImages().at(0), 2);
+    compareReduction(image, builder.reducedImages().at(1), 3);
+}
+
+void ImageBuilderTest::reduceColor()
+{
+    const int width = 6;
+    const int height = 5;
+    QByteArray data(width * height * 3, 0);
+    for (int i = 0; i < data.size(); i++) {
+        data[i] = static_cast<char>((i * 37) & 0xFF);
+    }
+
+    QImage image;
+    int dpi = 150;
+    ImageBuilder builder(&image, &dpi);
+    builder.setReductionFactors({4});
+    builder.start(parameters(SANE_FRAME_RGB, 8, width, height));
+    copyRows(builder, data, width * 3, 0, height);
+    builder.finish();
+
+    QCOMPARE(image.format(), QImage::Format_RGB32);
+    QCOMPARE(builder.reducedImages().size(), 1);
+    QCOMPARE(builder.reducedImages().at(0).format(), QImage::Format_RGB32);
+    compareReduction(image, builder.reducedImages().at(0), 4);
+}
+
+void ImageBuilderTest::reduceMono()
+{
+    const int width = 16;
+    const int height = 4;
+    // alternating black and white pixels in the upper half, black in the lower half
+    QByteArray data(width / 8 * height, static_cast<char>(0xFF));
+    data.replace(0, width / 8 * 2, QByteArray(width / 8 * 2, static_cast<char>(0xAA)));
+
+    QImage image;
+    int dpi = 300;
+    ImageBuilder builder(&image, &dpi);
+    builder.setReductionFactors({2});
+    builder.start(parameters(SANE_FRAME_GRAY, 1, width, height));
+    copyRows(builder, data, width / 8, 0, height);
+    builder.finish();
+
+    // averaged monochrome pixels are gray
+    const QImage reduced = builder.reducedImages().at(0);
+    QCOMPARE(reduced.format(), QImage::Format_Grayscale8);
+    QCOMPARE(reduced.size(), QSize(8, 2));
+    for (int x = 0; x < reduced.width(); x++) {
+        QCOMPARE(reduced.pixel(x, 0), qRgb(0x7F, 0x7F, 0x7F));
+        QCOMPARE(reduced.pixel(x, 1), qRgb(0, 0, 0));
+    }
+}
+
+void ImageBuilderTest::changedFactors()
+{
+    const QByteArray data(8 * 8, static_cast<char>(0x40));
+
+    QImage image;
+    int dpi = 300;
+    ImageBuilder builder(&image, &dpi);
+    builder.setReductionFactors({2});
+    builder.start(parameters(SANE_FRAME_GRAY, 8, 8, 8));
+
+    // the page in progress keeps its factors
+    builder.setReductionFactors({4});
+    copyRows(builder, data, 8, 0, 8);
+    builder.finish();
+    const QImage firstPage = builder.reducedImages().at(0);
+    QCOMPARE(firstPage.size(), QSize(4, 4));
+    QCOMPARE(firstPage.pixel(3, 3), qRgb(0x40, 0x40, 0x40));
+
+    builder.start(parameters(SANE_FRAME_GRAY, 8, 8, 8));
+    QCOMPARE(builder.reducedImages().at(0).size(), QSize(2, 2));
+    copyRows(builder, QByteArray(8 * 8, 0), 8, 0, 8);
+    builder.finish();
+    QCOMPARE(builder.reducedImages().at(0).pixel(0, 0), qRgb(0, 0, 0));
+    // the reduced images of the previous page are not overwritten
+    QCOMPARE(firstPage.pixel(0, 0), qRgb(0x40, 0x40, 0x40));
+}
+
+QTEST_GUILESS_MAIN(ImageBuilderTest)
+
+#include "imagebuildertest.moc"
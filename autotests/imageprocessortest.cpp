@@ -0,0 +1,185 @@
+/*
+ * SPDX-FileCopyrightText: 2026 KSaneCore developers
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+ */
+
+#include <QImage>
+#include <QTest>
+
+#include "imageprocessor.h"
+
+using namespace KSaneCore;
+
+class ImageProcessorTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void convertToMono_data();
+    void convertToMono();
+    void subImage();
+    void subImageBounds_data();
+    void subImageBounds();
+    void subImageMono();
+    void deskew_data();
+    void deskew();
+};
+
+void ImageProcessorTest::convertToMono_data()
+{
+    QTest::addColumn<QImage>("image");
+
+    // enough rows to be converted in several bands
+    const int width = 300;
+    const int height = 500;
+
+    QImage gray8(width, height, QImage::Format_Grayscale8);
+    for (int y = 0; y < height; y++) {
+        uchar *line = gray8.scanLine(y);
+        for (int x = 0; x < width; x++) {
+            line[x] = (x + y) & 0xFF;
+        }
+    }
+    QTest::newRow("Grayscale8") << gray8;
+    QTest::newRow("Grayscale16") << gray8.convertToFormat(QImage::Format_Grayscale16);
+    QTest::newRow("RGB32") << gray8.convertToFormat(QImage::Format_RGB32);
+    QTest::newRow("RGBX64") << gray8.convertToFormat(QImage::Format_RGBX64);
+}
+
+void ImageProcessorTest::convertToMono()
+{
+    QFETCH(QImage, image);
+    image.setDotsPerMeterX(11811);
+    image.setDotsPerMeterY(5906);
+
+    const QImage mono = ImageProcessor::convertToMono(image);
+    QCOMPARE(mono.format(), QImage::Format_Mono);
+    QCOMPARE(mono.size(), image.size());
+    QCOMPARE(mono.dotsPerMeterX(), image.dotsPerMeterX());
+    QCOMPARE(mono.dotsPerMeterY(), image.dotsPerMeterY());
+    // pixels darker than half of the maximum value are black
+    for (int y = 0; y < image.height(); y++) {
+        for (int x = 0; x < image.width(); x++) {
+            const bool black = ((x + y) & 0xFF) < 0x80;
+            QCOMPARE(mono.pixel(x, y), black ? qRgb(0, 0, 0) : qRgb(0xFF, 0xFF, 0xFF));
+        }
+    }
+
+    // monochrome images are returned as they are
+    QCOMPARE(ImageProcessor::convertToMono(mono).cacheKey(), mono.cacheKey());
+}
+
+void ImageProcessorTest::subImage()
+{
+    QImage image(100, 50, QImage::Format_RGB32);
+    for (int y = 0; y < image.height(); y++) {
+        QRgb *pixels = reinterpret_cast<QRgb *>(image.scanLine(y));
+        for (int x = 0; x < image.width(); x++) {
+            pixels[x] = qRgb(x, y, 0);
+        }
+    }
+    image.setDotsPerMeterX(11811);
+
+    QImage sub = ImageProcessor::subImage(image, QRect(10, 5, 20, 10));
+    QCOMPARE(sub.size(), QSize(20, 10));
+    QCOMPARE(sub.dotsPerMeterX(), image.dotsPerMeterX());
+    // the data is shared, not copied
+    QCOMPARE(sub.constBits(), image.constBits() + 5 * image.bytesPerLine() + 10 * 4);
+    QCOMPARE(sub.bytesPerLine(), image.bytesPerLine());
+    QCOMPARE(sub.pixel(0, 0), qRgb(10, 5, 0));
+    QCOMPARE(sub.pixel(19, 9), qRgb(29, 14, 0));
+
+    // the sub image keeps the data alive
+    image = QImage();
+    QCOMPARE(sub.pixel(19, 9), qRgb(29, 14, 0));
+}
+
+void ImageProcessorTest::subImageBounds_data()
+{
+    QTest::addColumn<QRect>("area");
+    QTest::addColumn<QSize>("size");
+
+    QTest::newRow("inside") << QRect(10, 10, 30, 20) << QSize(30, 20);
+    QTest::newRow("right bottom edge") << QRect(90, 40, 20, 20) << QSize(10, 10);
+    QTest::newRow("left top edge") << QRect(-5, -5, 10, 10) << QSize(5, 5);
+    QTest::newRow("whole image") << QRect(0, 0, 100, 50) << QSize(100, 50);
+    QTest::newRow("larger than image") << QRect(-10, -10, 200, 200) << QSize(100, 50);
+    // nothing to crop, the image is returned as it is
+    QTest::newRow("outside") << QRect(200, 200, 10, 10) << QSize(100, 50);
+    QTest::newRow("empty") << QRect() << QSize(100, 50);
+}
+
+void ImageProcessorTest::subImageBounds()
+{
+    QFETCH(QRect, area);
+    QFETCH(QSize, size);
+
+    QImage image(100, 50, QImage::Format_Grayscale8);
+    image.fill(0x80);
+    const QImage sub = ImageProcessor::subImage(image, area);
+    QCOMPARE(sub.size(), size);
+    QCOMPARE(sub.pixelColor(sub.width() - 1, sub.height() - 1), image.pixelColor(0, 0));
+}
+
+void ImageProcessorTest::subImageMono()
+{
+    QImage image(64, 8, QImage::Format_Mono);
+    image.setColorTable(QVector<QRgb>({0xFFFFFFFF, 0xFF000000}));
+    image.fill(0);
+    // every 8th pixel is black
+    for (int x = 0; x < image.width(); x += 8) {
+        image.setPixel(x, 2, 1);
+    }
+
+    // the left edge moves to the start of the byte
+    const QImage sub = ImageProcessor::subImage(image, QRect(10, 2, 8, 4));
+    QCOMPARE(sub.size(), QSize(10, 4));
+    QCOMPARE(sub.colorTable(), image.colorTable());
+    QCOMPARE(sub.pixel(0, 0), qRgb(0, 0, 0));
+    QCOMPARE(sub.pixel(1, 0), qRgb(0xFF, 0xFF, 0xFF));
+    QCOMPARE(sub.pixel(8, 0), qRgb(0, 0, 0));
+}
+
+void ImageProcessorTest::deskew_data()
+{
+    QTest::addColumn<int>("format");
+
+    QTest::newRow("mono") << int(QImage::Format_Mono);
+    QTest::newRow("gray") << int(QImage::Format_Grayscale8);
+    QTest::newRow("gray 16 bit") << int(QImage::Format_Grayscale16);
+    QTest::newRow("color") << int(QImage::Format_RGB32);
+}
+
+void ImageProcessorTest::deskew()
+{
+    QFETCH(int, format);
+
+    QImage image(200, 100, QImage::Format(format));
+    if (image.format() == QImage::Format_Mono) {
+        image.setColorTable(QVector<QRgb>({0xFFFFFFFF, 0xFF000000}));
+    }
+    image.setDotsPerMeterX(11811);
+    image.setDotsPerMeterY(11811);
+    image.fill(QColor(Qt::black));
+
+    // nothing moves without an angle
+    const QImage unchanged = ImageProcessor::deskew(image, 0);
+    QCOMPARE(unchanged.format(), image.format());
+    QCOMPARE(unchanged, image);
+
+    // the corners rotate out of the page and are filled with white
+    const QImage rotated = ImageProcessor::deskew(image, 3);
+    QCOMPARE(rotated.format(), image.format());
+    QCOMPARE(rotated.size(), image.size());
+    QCOMPARE(rotated.dotsPerMeterX(), image.dotsPerMeterX());
+    QCOMPARE(rotated.pixel(0, 0), qRgb(0xFF, 0xFF, 0xFF));
+    QCOMPARE(rotated.pixel(199, 0), qRgb(0xFF, 0xFF, 0xFF));
+    QCOMPARE(rotated.pixel(0, 99), qRgb(0xFF, 0xFF, 0xFF));
+    QCOMPARE(rotated.pixel(199, 99), qRgb(0xFF, 0xFF, 0xFF));
+    QCOMPARE(rotated.pixel(100, 50), qRgb(0, 0, 0));
+}
+
+QTEST_GUILESS_MAIN(ImageProcessorTest)
+
+#include "imageprocessortest.moc"
@@ -0,0 +1,169 @@
+/*
+ * SPDX-FileCopyrightText: 2026 KSaneCore developers
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+ */
+
+#include <QImage>
+#include <QTest>
+
+#include "imageregionview.h"
+
+using namespace KSaneCore;
+
+static const int TILE_SIZE = ImageRegionView::TILE_SIZE;
+
+class ImageRegionViewTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void tiles();
+    void tileBounds_data();
+    void tileBounds();
+    void region_data();
+    void region();
+    void replaceImage();
+
+private:
+    static QImage createImage();
+};
+
+QImage ImageRegionViewTest::createImage()
+{
+    // two and a half tiles wide, two and three quarter tiles high
+    QImage image(TILE_SIZE * 5 / 2, TILE_SIZE * 11 / 4, QImage::Format_RGB32);
+    for (int y = 0; y < image.height(); y++) {
+        QRgb *pixels = reinterpret_cast<QRgb *>(image.scanLine(y));
+        for (int x = 0; x < image.width(); x++) {
+            pixels[x] = qRgb(x & 0xFF, y & 0xFF, (x + y) & 0xFF);
+        }
+    }
+    return image;
+}
+
+void ImageRegionViewTest::tiles()
+{
+    const QImage image = createImage();
+    ImageRegionView tiles;
+    tiles.start(image);
+    QCOMPARE(tiles.columns(), 3);
+    QCOMPARE(tiles.completedTileRows(), 0);
+    QVERIFY(tiles.tile(0, 0).isNull());
+
+    // a tile row is complete with its last row
+    tiles.setCompletedRows(TILE_SIZE - 1);
+    QCOMPARE(tiles.completedTileRows(), 0);
+    tiles.setCompletedRows(TILE_SIZE);
+    QCOMPARE(tiles.completedTileRows(), 1);
+
+    const QImage tile = tiles.tile(1, 0);
+    QCOMPARE(tile.size(), QSize(TILE_SIZE, TILE_SIZE));
+    QCOMPARE(tile.pixel(0, 0), image.pixel(TILE_SIZE, 0));
+    // the tile shares the data of the image
+    QCOMPARE(tile.constBits(), image.constBits() + TILE_SIZE * 4);
+    QVERIFY(tiles.tile(1, 1).isNull());
+
+    // the last tile row is shorter and complete with the image
+    tiles.setCompletedRows(TILE_SIZE * 11 / 4 - 1);
+    QCOMPARE(tiles.completedTileRows(), 2);
+    tiles.setCompletedRows(image.height() + 10);
+    QCOMPARE(tiles.completedTileRows(), 3);
+
+    tiles.clear();
+    QCOMPARE(tiles.columns(), 0);
+    QCOMPARE(tiles.completedTileRows(), 0);
+    QVERIFY(tiles.tile(0, 0).isNull());
+}
+
+void ImageRegionViewTest::tileBounds_data()
+{
+    QTest::addColumn<int>("column");
+    QTest::addColumn<int>("row");
+    QTest::addColumn<QRect>("area");
+
+    QTest::newRow("first") << 0 << 0 << QRect(0, 0, TILE_SIZE, TILE_SIZE);
+    QTest::newRow("inner") << 1 << 1 << QRect(TILE_SIZE, TILE_SIZE, TILE_SIZE, TILE_SIZE);
+    QTest::newRow("right edge") << 2 << 0 << QRect(TILE_SIZE * 2, 0, TILE_SIZE / 2, TILE_SIZE);
+    QTest::newRow("bottom edge") << 0 << 2 << QRect(0, TILE_SIZE * 2, TILE_SIZE, TILE_SIZE * 3 / 4);
+    QTest::newRow("corner") << 2 << 2 << QRect(TILE_SIZE * 2, TILE_SIZE * 2, TILE_SIZE / 2, TILE_SIZE * 3 / 4);
+    QTest::newRow("right of image") << 3 << 0 << QRect();
+    QTest::newRow("below image") << 0 << 3 << QRect();
+    QTest::newRow("negative column") << -1 << 0 << QRect();
+    QTest::newRow("negative row") << 0 << -1 << QRect();
+}
+
+void ImageRegionViewTest::tileBounds()
+{
+    QFETCH(int, column);
+    QFETCH(int, row);
+    QFETCH(QRect, area);
+
+    const QImage image = createImage();
+    ImageRegionView tiles;
+    tiles.start(image);
+    tiles.setCompletedRows(image.height());
+
+    const QImage tile = tiles.tile(column, row);
+    if (area.isNull()) {
+        QVERIFY(tile.isNull());
+        return;
+    }
+    QCOMPARE(tile.size(), area.size());
+    QCOMPARE(tile.pixel(0, 0), image.pixel(area.topLeft()));
+    QCOMPARE(tile.pixel(tile.width() - 1, tile.height() - 1), image.pixel(area.bottomRight()));
+}
+
+void ImageRegionViewTest::region_data()
+{
+    QTest::addColumn<QRect>("area");
+    QTest::addColumn<QRect>("expectedArea");
+
+    // the first 300 rows are complete
+    QTest::newRow("complete") << QRect(10, 20, 100, 200) << QRect(10, 20, 100, 200);
+    QTest::newRow("last complete row") << QRect(0, 290, 50, 10) << QRect(0, 290, 50, 10);
+    QTest::newRow("incomplete row") << QRect(0, 290, 50, 11) << QRect();
+    QTest::newRow("clipped") << QRect(-10, -10, 1000, 100) << QRect(0, 0, TILE_SIZE * 5 / 2, 90);
+    QTest::newRow("outside") << QRect(1000, 0, 10, 10) << QRect();
+    QTest::newRow("empty") << QRect() << QRect();
+}
+
+void ImageRegionViewTest::region()
+{
+    QFETCH(QRect, area);
+    QFETCH(QRect, expectedArea);
+
+    const QImage image = createImage();
+    ImageRegionView tiles;
+    tiles.start(image);
+    tiles.setCompletedRows(300);
+
+    const QImage region = tiles.region(area);
+    if (expectedArea.isNull()) {
+        QVERIFY(region.isNull());
+        return;
+    }
+    QCOMPARE(region.size(), expectedArea.size());
+    QCOMPARE(region.pixel(0, 0), image.pixel(expectedArea.topLeft()));
+    QCOMPARE(region.pixel(region.width() - 1, region.height() - 1), image.pixel(expectedArea.bottomRight()));
+}
+
+void ImageRegionViewTest::replaceImage()
+{
+    ImageRegionView tiles;
+    tiles.start(createImage());
+    tiles.setCompletedRows(TILE_SIZE * 2);
+    QCOMPARE(tiles.completedTileRows(), 2);
+
+    // the completed rows are limited to the new image
+    QImage cropped = createImage().copy(0, 0, TILE_SIZE, TILE_SIZE * 3 / 2);
+    tiles.replaceImage(cropped);
+    QCOMPARE(tiles.columns(), 1);
+    QCOMPARE(tiles.completedTileRows(), 2);
+    QCOMPARE(tiles.tile(0, 1).size(), QSize(TILE_SIZE, TILE_SIZE / 2));
+    QVERIFY(tiles.tile(0, 2).isNull());
+}
+
+QTEST_GUILESS_MAIN(ImageRegionViewTest)
+
+#include "imageregionviewtest.moc"
@@ -0,0 +1,125 @@
+/*
+ * SPDX-FileCopyrightText: 2026 KSaneCore developers
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+ */
+
+#include <memory>
+#include <vector>
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QImage>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include "interface.h"
+
+using namespace KSaneCore;
+
+static const int MAXIMUM_DEVICES = 8;
+
+/* Scans with several fake devices of the SANE test backend at the same time. The
+ * devices are slowed down like real ones, so the total throughput should grow with
+ * the number of devices as long as the devices do not block each other. */
+class MultiDeviceTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void concurrentScans_data();
+    void concurrentScans();
+
+private:
+    bool writeConfig(const QString &fileName, const QByteArray &content);
+
+    QTemporaryDir m_configDir;
+    double m_singleDeviceThroughput = 0;
+};
+
+bool MultiDeviceTest::writeConfig(const QString &fileName, const QByteArray &content)
+{
+    QFile file(m_configDir.filePath(fileName));
+    return file.open(QIODevice::WriteOnly) && file.write(content) == content.size();
+}
+
+void MultiDeviceTest::initTestCase()
+{
+    QVERIFY(m_configDir.isValid());
+    // only the test backend is loaded, it provides the fake devices
+    QVERIFY(writeConfig(QStringLiteral("dll.conf"), "test\n"));
+    // small reads with a delay keep the devices busy like real scanners
+    QVERIFY(writeConfig(QStringLiteral("test.conf"),
+                        "number_of_devices " + QByteArray::number(MAXIMUM_DEVICES) + "\n"
+                        "mode Gray\n"
+                        "depth 8\n"
+                        "resolution 75\n"
+                        "read-limit true\n"
+                        "read-limit-size 1024\n"
+                        "read-delay true\n"
+                        "read-delay-duration 1000\n"));
+    qputenv("SANE_CONFIG_DIR", QFile::encodeName(m_configDir.path()));
+}
+
+void MultiDeviceTest::concurrentScans_data()
+{
+    QTest::addColumn<int>("devices");
+
+    for (int devices = 1; devices <= MAXIMUM_DEVICES; devices *= 2) {
+        QTest::newRow(qPrintable(QStringLiteral("%1 devices").arg(devices))) << devices;
+    }
+}
+
+void MultiDeviceTest::concurrentScans()
+{
+    QFETCH(int, devices);
+
+    // declared before the devices, they are used until the devices are destroyed
+    qint64 bytes = 0;
+    int finished = 0;
+    int failed = 0;
+
+    std::vector<std::unique_ptr<Interface>> scanners;
+    for (int i = 0; i < devices; i++) {
+        auto scanner = std::make_unique<Interface>();
+        if (scanner->openDevice(QStringLiteral("test:%1").arg(i)) != Interface::OpeningSucceeded) {
+            QSKIP("The SANE test backend is not available");
+        }
+        connect(scanner.get(), &Interface::scannedImageReady, this, [&bytes](const QImage &image) {
+            bytes += image.sizeInBytes();
+        });
+        connect(scanner.get(), &Interface::scanFinished, this, [&finished, &failed](Interface::ScanStatus status) {
+            finished++;
+            if (status == Interface::ErrorGeneral) {
+                failed++;
+            }
+        });
+        scanners.push_back(std::move(scanner));
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    for (const auto &scanner : scanners) {
+        scanner->startScan();
+    }
+    QTRY_COMPARE_WITH_TIMEOUT(finished, devices, 60000);
+    const qint64 elapsed = qMax<qint64>(timer.elapsed(), 1);
+    QCOMPARE(failed, 0);
+    QVERIFY(bytes > 0);
+
+    const double throughput = bytes / 1024.0 / 1024.0 * 1000.0 / elapsed;
+    if (devices == 1) {
+        m_singleDeviceThroughput = throughput;
+    }
+    const double scaling = m_singleDeviceThroughput > 0 ? throughput / m_singleDeviceThroughput : 0;
+    qInfo("%d devices: %.2f MiB/s in total, %.2f times the throughput of a single device", devices, throughput, scaling);
+    // the bound is loose, devices which wait for each other stay close to the single device
+    if (devices >= 4) {
+        QVERIFY2(scaling >= 1.5, qPrintable(QStringLiteral("%1 devices only reach %2 times the throughput of a single device").arg(devices).arg(scaling)));
+    }
+}
+
+QTEST_MAIN(MultiDeviceTest)
+
+#include "multidevicetest.moc"
@@ -0,0 +1,196 @@
+/*
+ * SPDX-FileCopyrightText: 2026 KSaneCore developers
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+ */
+
+#include <cstring>
+
+#include <QtMath>
+
+#include <QImage>
+#include <QTest>
+
+#include "imageprocessor.h"
+#include "pageanalyzer.h"
+
+using namespace KSaneCore;
+
+static const int PAGE_SIZE = 200;
+
+class PageAnalyzerTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void blankPage_data();
+    void blankPage();
+    void disabledAnalyses();
+    void skew();
+    void perceptualHashUnknownLines();
+
+private:
+    static void analyze(PageAnalyzer &analyzer, const QImage &image);
+};
+
+void PageAnalyzerTest::analyze(PageAnalyzer &analyzer, const QImage &image)
+{
+    // the rows arrive in several parts like from the image builder
+    analyzer.start(image, image.height());
+    analyzer.analyzeRows(image, 0, image.height() / 3);
+    analyzer.analyzeRows(image, image.height() / 3, image.height());
+    analyzer.finish();
+}
+
+void PageAnalyzerTest::blankPage_data()
+{
+    QTest::addColumn<QImage>("image");
+    QTest::addColumn<bool>("blank");
+
+    QImage white(PAGE_SIZE, PAGE_SIZE, QImage::Format_Grayscale8);
+    white.fill(0xFF);
+    QTest::newRow("white") << white << true;
+
+    // the border of the scanner lid lies within the ignored margins
+    QImage border = white.copy();
+    for (int y = 0; y < PAGE_SIZE; y++) {
+        uchar *line = border.scanLine(y);
+        for (int x = 0; x < 5; x++) {
+            line[x] = 0;
+            line[PAGE_SIZE - 1 - x] = 0;
+        }
+    }
+    QTest::newRow("dark border") << border << true;
+
+    // a few specks of dust stay below the maximum ink ratio
+    QImage dust = white.copy();
+    for (int i = 0; i < 10; i++) {
+        dust.scanLine(50 + i * 10)[60 + i * 7] = 0;
+    }
+    QTest::newRow("dust") << dust << true;
+
+    QImage text = white.copy();
+    for (int y = 80; y < 100; y++) {
+        memset(text.scanLine(y) + 40, 0, 60);
+    }
+    QTest::newRow("text") << text << false;
+
+    // light gray areas are not ink, but the brightness varies too much
+    QImage photo = white.copy();
+    for (int y = PAGE_SIZE / 2; y < PAGE_SIZE; y++) {
+        memset(photo.scanLine(y), 0xA0, PAGE_SIZE);
+    }
+    QTest::newRow("light photo") << photo << false;
+
+    QImage color(PAGE_SIZE, PAGE_SIZE, QImage::Format_RGB32);
+    color.fill(Qt::white);
+    QTest::newRow("white color") << color << true;
+    for (int y = 80; y < 100; y++) {
+        QRgb *pixels = reinterpret_cast<QRgb *>(color.scanLine(y));
+        for (int x = 40; x < 100; x++) {
+            pixels[x] = qRgb(0, 0, 128);
+        }
+    }
+    QTest::newRow("color text") << color << false;
+}
+
+void PageAnalyzerTest::blankPage()
+{
+    QFETCH(QImage, image);
+    QFETCH(bool, blank);
+
+    PageAnalyzer analyzer;
+    analyzer.setBlankPageDetection(0.005, 5);
+    analyze(analyzer, image);
+    QCOMPARE(analyzer.isBlankPage(), blank);
+    QCOMPARE(analyzer.metadata().value(QStringLiteral("blankPage")).toBool(), blank);
+}
+
+void PageAnalyzerTest::disabledAnalyses()
+{
+    QImage image(PAGE_SIZE, PAGE_SIZE, QImage::Format_Grayscale8);
+    image.fill(0xFF);
+
+    PageAnalyzer analyzer;
+    analyzer.setAnalyses(PageAnalyzer::ContentAnalysis);
+    analyze(analyzer, image);
+    // the page is not examined and does not count as blank
+    QVERIFY(!analyzer.isBlankPage());
+    const QVariantMap metadata = analyzer.metadata();
+    QVERIFY(!metadata.contains(QStringLiteral("blankPage")));
+    QVERIFY(!metadata.contains(QStringLiteral("histograms")));
+    QVERIFY(!metadata.contains(QStringLiteral("pageType")));
+    QVERIFY(metadata.contains(QStringLiteral("contentArea")));
+    QVERIFY(analyzer.contentArea().isNull());
+}
+
+void PageAnalyzerTest::skew()
+{
+    QImage image(400, 300, QImage::Format_Grayscale8);
+    image.fill(0xFF);
+    PageAnalyzer analyzer;
+    analyzer.setAnalyses(PageAnalyzer::SkewAnalysis);
+    analyze(analyzer, image);
+    QCOMPARE(analyzer.skewAngle(), 0.0);
+
+    // lines of text which descend to the right by 2 degrees
+    const double slope = qTan(qDegreesToRadians(2.0));
+    for (int y0 = 20; y0 < 270; y0 += 20) {
+        for (int x = 0; x < image.width(); x++) {
+            const int y = y0 + qRound(x * slope);
+            image.scanLine(y)[x] = 0;
+            image.scanLine(y + 1)[x] = 0;
+        }
+    }
+    analyze(analyzer, image);
+    QVERIFY(qAbs(analyzer.skewAngle() - 2.0) <= 0.25);
+    QCOMPARE(analyzer.metadata().value(QStringLiteral("skewAngle")).toDouble(), analyzer.skewAngle());
+
+    // the profiles of handscanner images grow with the rows
+    analyzer.start(image, -1);
+    analyzer.analyzeRows(image, 0, image.height());
+    analyzer.finish();
+    QVERIFY(qAbs(analyzer.skewAngle() - 2.0) <= 0.25);
+
+    analyze(analyzer, ImageProcessor::deskew(image, 2.0));
+    QVERIFY(qAbs(analyzer.skewAngle()) <= 0.25);
+
+    // the skew is not estimated with the other analyses
+    analyzer.setAnalyses(PageAnalyzer::AllAnalyses);
+    analyze(analyzer, image);
+    QCOMPARE(analyzer.skewAngle(), 0.0);
+    QVERIFY(!analyzer.metadata().contains(QStringLiteral("skewAngle")));
+}
+
+void PageAnalyzerTest::perceptualHashUnknownLines()
+{
+    QImage image(PAGE_SIZE, PAGE_SIZE, QImage::Format_Grayscale8);
+    image.fill(0xFF);
+    for (int y = 0; y < PAGE_SIZE / 2; y++) {
+        memset(image.scanLine(y), 0, PAGE_SIZE / 3);
+    }
+
+    PageAnalyzer analyzer;
+    analyzer.setHashing(true);
+    analyze(analyzer, image);
+    const quint64 perceptualHash = analyzer.perceptualHash();
+    QVERIFY(perceptualHash != 0);
+
+    // handscanners do not know the number of lines, the grid follows the received rows
+    analyzer.start(image, -1);
+    analyzer.analyzeRows(image, 0, image.height() / 3);
+    analyzer.analyzeRows(image, image.height() / 3, image.height());
+    analyzer.finish();
+    QCOMPARE(analyzer.perceptualHash(), perceptualHash);
+    QCOMPARE(analyzer.metadata().value(QStringLiteral("perceptualHash")).toULongLong(), perceptualHash);
+
+    // without rows there is no perceptual hash, which would be similar to any other page
+    analyzer.start(image, -1);
+    analyzer.finish();
+    QVERIFY(analyzer.metadata().contains(QStringLiteral("sha256")));
+    QVERIFY(!analyzer.metadata().contains(QStringLiteral("perceptualHash")));
+}
+
+QTEST_GUILESS_MAIN(PageAnalyzerTest)
+
+#include "pageanalyzertest.moc"
@@ -0,0 +1,101 @@
+/*
+ * SPDX-FileCopyrightText: 2026 KSaneCore developers
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+ */
+
+#include <QFile>
+#include <QImage>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include "interface.h"
+#include "option.h"
+
+using namespace KSaneCore;
+
+/* Reuses the preview of a device of the SANE test backend, which has a preview option,
+ * for the final scan. */
+class PreviewCacheTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void reusePreview();
+
+private:
+    bool writeConfig(const QString &fileName, const QByteArray &content);
+
+    QTemporaryDir m_configDir;
+};
+
+bool PreviewCacheTest::writeConfig(const QString &fileName, const QByteArray &content)
+{
+    QFile file(m_configDir.filePath(fileName));
+    return file.open(QIODevice::WriteOnly) && file.write(content) == content.size();
+}
+
+void PreviewCacheTest::initTestCase()
+{
+    QVERIFY(m_configDir.isValid());
+    QVERIFY(writeConfig(QStringLiteral("dll.conf"), "test\n"));
+    QVERIFY(writeConfig(QStringLiteral("test.conf"),
+                        "number_of_devices 1\n"
+                        "mode Gray\n"
+                        "depth 8\n"
+                        "resolution 75\n"));
+    qputenv("SANE_CONFIG_DIR", QFile::encodeName(m_configDir.path()));
+}
+
+void PreviewCacheTest::reusePreview()
+{
+    Interface scanner;
+    if (scanner.openDevice(QStringLiteral("test:0")) != Interface::OpeningSucceeded) {
+        QSKIP("The SANE test backend is not available");
+    }
+    QVERIFY(scanner.getOption(Interface::PreviewOption) != nullptr);
+    scanner.setReusePreviewScan(true);
+    scanner.setPreviewResolution(75);
+
+    QImage preview;
+    QImage image;
+    bool previewFinished = false;
+    bool scanFinished = false;
+    connect(&scanner, &Interface::previewImageReady, this, [&preview](const QImage &previewImage) {
+        preview = previewImage;
+    });
+    connect(&scanner, &Interface::scannedImageReady, this, [&image](const QImage &scannedImage) {
+        image = scannedImage;
+    });
+    connect(&scanner, &Interface::previewScanFinished, this, [&previewFinished]() {
+        previewFinished = true;
+    });
+    connect(&scanner, &Interface::scanFinished, this, [&scanFinished]() {
+        scanFinished = true;
+    });
+
+    scanner.startPreviewScan();
+    QTRY_VERIFY_WITH_TIMEOUT(previewFinished, 30000);
+    QVERIFY(!preview.isNull());
+    // the preview option has been reset for the final scan
+    QCOMPARE(scanner.getOption(Interface::PreviewOption)->value().toBool(), false);
+
+    // an area within the preview with the resolution of the preview
+    scanner.getOption(Interface::ResolutionOption)->setValue(75);
+    scanner.getOption(Interface::TopLeftXOption)->setValue(10);
+    scanner.getOption(Interface::TopLeftYOption)->setValue(10);
+    scanner.getOption(Interface::BottomRightXOption)->setValue(50);
+    scanner.getOption(Interface::BottomRightYOption)->setValue(50);
+    scanner.startScan();
+    QTRY_VERIFY_WITH_TIMEOUT(scanFinished, 30000);
+    QVERIFY(!image.isNull());
+
+    // the image has been cropped from the preview and shares its data
+    QVERIFY(image.constBits() >= preview.constBits());
+    QVERIFY(image.constBits() < preview.constBits() + preview.sizeInBytes());
+}
+
+QTEST_MAIN(PreviewCacheTest)
+
+#include "previewcachetest.moc"
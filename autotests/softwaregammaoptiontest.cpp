@@ -0,0 +1,86 @@
+/*
+ * SPDX-FileCopyrightText: 2026 KSaneCore developers
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+ */
+
+#include <QSignalSpy>
+#include <QTest>
+
+#include "gammaoption.h"
+#include "softwaregammaoption.h"
+
+using namespace KSaneCore;
+
+class SoftwareGammaOptionTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void setValue_data();
+    void setValue();
+    void invalidValue();
+    void gammaTableLimits();
+};
+
+void SoftwareGammaOptionTest::setValue_data()
+{
+    QTest::addColumn<QVariant>("value");
+    QTest::addColumn<QVariantList>("expected");
+
+    QTest::newRow("in range") << QVariant(QStringLiteral("10:-20:150")) << QVariantList{10, -20, 150};
+    QTest::newRow("list") << QVariant(QVariantList{-5, 5, 80}) << QVariantList{-5, 5, 80};
+    QTest::newRow("contrast 100") << QVariant(QStringLiteral("0:100:100")) << QVariantList{0, GammaOption::MAX_CONTRAST, 100};
+    QTest::newRow("gamma 0") << QVariant(QStringLiteral("0:0:0")) << QVariantList{0, 0, GammaOption::MIN_GAMMA};
+    QTest::newRow("too low") << QVariant(QVariantList{-1000, -1000, -1000})
+                             << QVariantList{GammaOption::MIN_BRIGHTNESS, GammaOption::MIN_CONTRAST, GammaOption::MIN_GAMMA};
+    QTest::newRow("too high") << QVariant(QVariantList{1000, 1000, 1000})
+                              << QVariantList{GammaOption::MAX_BRIGHTNESS, GammaOption::MAX_CONTRAST, GammaOption::MAX_GAMMA};
+}
+
+void SoftwareGammaOptionTest::setValue()
+{
+    QFETCH(QVariant, value);
+    QFETCH(QVariantList, expected);
+
+    SoftwareGammaOption option;
+    QSignalSpy spy(&option, &BaseOption::valueChanged);
+    QVERIFY(option.setValue(value));
+    QCOMPARE(option.value().toList(), expected);
+    QCOMPARE(spy.count(), 1);
+
+    // the clamped value is the same
+    QVERIFY(option.setValue(value));
+    QCOMPARE(spy.count(), 1);
+}
+
+void SoftwareGammaOptionTest::invalidValue()
+{
+    SoftwareGammaOption option;
+    QVERIFY(!option.setValue(QStringLiteral("1:2")));
+    QVERIFY(!option.setValue(QStringLiteral("1:a:3")));
+    QVERIFY(!option.setValue(QVariantList{1, 2, 3, 4}));
+    QCOMPARE(option.value().toList(), QVariantList({0, 0, 100}));
+
+    QCOMPARE(option.minimumValue().toList(), QVariantList({GammaOption::MIN_BRIGHTNESS, GammaOption::MIN_CONTRAST, GammaOption::MIN_GAMMA}));
+    QCOMPARE(option.maximumValue().toList(), QVariantList({GammaOption::MAX_BRIGHTNESS, GammaOption::MAX_CONTRAST, GammaOption::MAX_GAMMA}));
+}
+
+void SoftwareGammaOptionTest::gammaTableLimits()
+{
+    // values outside of the ranges are built like the clamped ones
+    QCOMPARE(GammaOption::gammaTable(0, 100, 100, 256, 0xFF), GammaOption::gammaTable(0, GammaOption::MAX_CONTRAST, 100, 256, 0xFF));
+    QCOMPARE(GammaOption::gammaTable(200, -200, 0, 256, 0xFF),
+             GammaOption::gammaTable(GammaOption::MAX_BRIGHTNESS, GammaOption::MIN_CONTRAST, GammaOption::MIN_GAMMA, 256, 0xFF));
+
+    const QVector<int> table = GammaOption::gammaTable(0, 100, 100, 256, 0xFF);
+    for (int value : table) {
+        QVERIFY(value >= 0 && value <= 0xFF);
+    }
+    // the curve still rises
+    QVERIFY(table.first() < table.last());
+}
+
+QTEST_GUILESS_MAIN(SoftwareGammaOptionTest)
+
+#include "softwaregammaoptiontest.moc"
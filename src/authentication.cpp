@@ -28,6 +28,8 @@ struct Authentication::Private {
     };
 
     QList<AuthStruct> authList;
+    // sane_open() may call authorization() from the threads of different devices
+    QMutex authMutex;
 };
 
 Authentication *Authentication::getInstance()
@@ -47,10 +49,12 @@ Authentication::~Authentication()
     QMutexLocker<QMutex> locker(s_mutex);
     d->authList.clear();
     delete d;
+    s_instance = nullptr;
 }
 
 void Authentication::setDeviceAuth(const QString &resource, const QString &username, const QString &password)
 {
+    QMutexLocker<QMutex> locker(&d->authMutex);
     // This is a short list so we do not need a QMap...
     int i;
     for (i = 0; i < d->authList.size(); i++) {
@@ -73,6 +77,7 @@ void Authentication::setDeviceAuth(const QString &resource, const QString &usern
 
 void Authentication::clearDeviceAuth(const QString &resource)
 {
+    QMutexLocker<QMutex> locker(&d->authMutex);
     // This is a short list so we do not need a QMap...
     for (int i = 0; i < d->authList.size(); i++) {
         if (resource == d->authList.at(i).resource) {
@@ -95,7 +100,10 @@ void Authentication::authorization(SANE_String_Const resource, SANE_Char *userna
     res = res.left(end);
     qCDebug(KSANECORE_LOG) << res;
 
-    const QList<Private::AuthStruct> list = getInstance()->d->authList;
+    Private *d = getInstance()->d;
+    d->authMutex.lock();
+    const QList<Private::AuthStruct> list = d->authList;
+    d->authMutex.unlock();
     for (const auto &authItem : list) {
         qCDebug(KSANECORE_LOG) << res << authItem.resource;
         if (authItem.resource.contains(res)) {
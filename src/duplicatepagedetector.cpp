@@ -0,0 +1,55 @@
+/*
+ * SPDX-FileCopyrightText: 2026 KSaneCore developers
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+ */
+
+#include "duplicatepagedetector.h"
+
+#include <QtAlgorithms>
+
+namespace KSaneCore
+{
+
+void DuplicatePageDetector::setDetection(int pages, int maximumDistance)
+{
+    m_pages = qMax(pages, 0);
+    m_maximumDistance = qBound(0, maximumDistance, 64);
+    m_recentPages.clear();
+}
+
+bool DuplicatePageDetector::isEnabled() const
+{
+    return m_pages > 0;
+}
+
+int DuplicatePageDetector::markPage(QVariantMap &metadata)
+{
+    if (m_pages <= 0 || !metadata.contains(QStringLiteral("perceptualHash")) || metadata.value(QStringLiteral("blankPage")).toBool()) {
+        return 0;
+    }
+    const QString sha256 = metadata.value(QStringLiteral("sha256")).toString();
+    const quint64 perceptualHash = metadata.value(QStringLiteral("perceptualHash")).toULongLong();
+
+    // the number of compared pages is fixed, the most recent one is checked first
+    int duplicatePage = 0;
+    bool exactDuplicate = false;
+    for (int i = m_recentPages.size() - 1; i >= 0; i--) {
+        const RecentPage &page = m_recentPages.at(i);
+        exactDuplicate = page.sha256 == sha256;
+        if (exactDuplicate || qPopulationCount(page.perceptualHash ^ perceptualHash) <= static_cast<uint>(m_maximumDistance)) {
+            duplicatePage = m_recentPages.size() - i;
+            break;
+        }
+    }
+    metadata[QStringLiteral("duplicatePage")] = duplicatePage;
+    metadata[QStringLiteral("exactDuplicate")] = exactDuplicate;
+
+    m_recentPages.append({sha256, perceptualHash});
+    while (m_recentPages.size() > m_pages) {
+        m_recentPages.removeFirst();
+    }
+    return duplicatePage;
+}
+
+} // namespace KSaneCore
@@ -0,0 +1,43 @@
+/*
+ * SPDX-FileCopyrightText: 2026 KSaneCore developers
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+ */
+
+#ifndef KSANE_DUPLICATE_PAGE_DETECTOR_H
+#define KSANE_DUPLICATE_PAGE_DETECTOR_H
+
+#include <QList>
+#include <QString>
+#include <QVariantMap>
+
+namespace KSaneCore
+{
+
+/* Compares the hashes in the metadata of every page with the ones of a fixed number of previous pages.
+ * A page is a duplicate if its SHA-256 hash is identical or its perceptual hash differs in only a few bits. */
+class DuplicatePageDetector
+{
+public:
+    /* Disables the detection for 0 pages, the distance is the number of bits which may differ */
+    void setDetection(int pages, int maximumDistance);
+    bool isEnabled() const;
+
+    /* Adds "duplicatePage" and "exactDuplicate" to the metadata and returns the number of pages
+     * before this one the page has been seen, 0 if it has not. Blank pages are not compared. */
+    int markPage(QVariantMap &metadata);
+
+private:
+    // the hashes of the last pages which are compared with every new page
+    struct RecentPage {
+        QString sha256;
+        quint64 perceptualHash = 0;
+    };
+    QList<RecentPage> m_recentPages;
+    int m_pages = 0;
+    int m_maximumDistance = 4;
+};
+
+} // namespace KSaneCore
+
+#endif // KSANE_DUPLICATE_PAGE_DETECTOR_H
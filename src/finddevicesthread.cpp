@@ -15,13 +15,23 @@ extern "C"
 #include <sane/sane.h>
 }
 
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
 #include <QMutex>
 #include <QMutexLocker>
+#include <QStandardPaths>
 
 #include <ksanecore_debug.h>
 
 #include "deviceinformation_p.h"
 
+#include <algorithm>
+
 namespace KSaneCore
 {
 static FindSaneDevicesThread *s_instancesane = nullptr;
@@ -55,58 +65,245 @@ FindSaneDevicesThread::FindSaneDevicesThread() : QThread(nullptr)
 {
 }
 
+static QString persistentCacheFile()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QStringLiteral("/ksanecore/devices.json");
+}
+
+static bool isSameDevice(const DeviceInformation *device, const DeviceInformation *other)
+{
+    return device->name() == other->name() && device->vendor() == other->vendor() && device->model() == other->model() && device->type() == other->type();
+}
+
 FindSaneDevicesThread::~FindSaneDevicesThread()
 {
     QMutexLocker<QMutex> locker(s_mutexsane);
-    qDeleteAll(m_deviceList);
     wait();
+    qDeleteAll(m_deviceList);
+    qDeleteAll(m_removedDeviceList);
+    s_instancesane = nullptr;
 }
 
 void FindSaneDevicesThread::run()
+{
+    QList<DeviceInformation *> foundDevices;
+
+    m_listMutex.lock();
+    const Interface::DeviceType deviceType = m_deviceType;
+    const bool reportLocalDevices = m_discoveryTimeout > 0;
+    m_listMutex.unlock();
+
+    // local devices are usually found quickly, report them before waiting for the network backends
+    if (reportLocalDevices && queryDevices(true, deviceType, foundDevices)) {
+        updateDevicesList(foundDevices, deviceType, false);
+        Q_EMIT localDevicesFound(addedDevices());
+        foundDevices.clear();
+    }
+
+    if (!queryDevices(false, deviceType, foundDevices)) {
+        QMutexLocker<QMutex> locker(&m_listMutex);
+        m_devicesListChanged = false;
+        return;
+    }
+    updateDevicesList(foundDevices, deviceType, true);
+    savePersistentCache();
+}
+
+bool FindSaneDevicesThread::queryDevices(bool localOnly, Interface::DeviceType deviceType, QList<DeviceInformation *> &foundDevices)
 {
     SANE_Device const **devList;
     SANE_Status         status;
 
     // This is unfortunately not very reliable as many back-ends do not refresh
     // the device list after the sane_init() call...
-    status = sane_get_devices(&devList, SANE_FALSE);
+    status = sane_get_devices(&devList, localOnly ? SANE_TRUE : SANE_FALSE);
 
-    qDeleteAll(m_deviceList);
-    m_deviceList.clear();
-    if (status == SANE_STATUS_GOOD) {
-        int i = 0;
-
-        while (devList[i] != nullptr) {
-            /* Do not list cameras as scanner devices when requested.
-             * Strings taken from SANE API documentation. */
-            const QString type = QString::fromUtf8(devList[i]->type);
-            if (m_deviceType == Interface::AllDevices
-                || (m_deviceType == Interface::NoCameraAndVirtualDevices && type != QLatin1String("still camera") && type != QLatin1String("video camera")
-                    && type != QLatin1String("virtual device"))) {
-                InternalDeviceInformation *device = new InternalDeviceInformation(QString::fromUtf8(devList[i]->name),
-                                                                                  QString::fromUtf8(devList[i]->vendor),
-                                                                                  QString::fromUtf8(devList[i]->model),
-                                                                                  type);
-                m_deviceList.append(std::move(device));
-                qCDebug(KSANECORE_LOG) << "Adding device " << device->vendor() << device->name() << device->model() << device->type() << " to device list";
-            } else {
-                qCDebug(KSANECORE_LOG) << "Ignoring device type" << type;
-            }
-            i++;
+    if (status != SANE_STATUS_GOOD) {
+        qCDebug(KSANECORE_LOG) << "sane_get_devices failed:" << sane_strstatus(status) << ", keeping the last known devices";
+        return false;
+    }
+
+    int i = 0;
+    while (devList[i] != nullptr) {
+        /* Do not list cameras as scanner devices when requested.
+         * Strings taken from SANE API documentation. */
+        const QString type = QString::fromUtf8(devList[i]->type);
+        if (deviceType == Interface::AllDevices
+            || (deviceType == Interface::NoCameraAndVirtualDevices && type != QLatin1String("still camera") && type != QLatin1String("video camera")
+                && type != QLatin1String("virtual device"))) {
+            InternalDeviceInformation *device = new InternalDeviceInformation(QString::fromUtf8(devList[i]->name),
+                                                                              QString::fromUtf8(devList[i]->vendor),
+                                                                              QString::fromUtf8(devList[i]->model),
+                                                                              type);
+            foundDevices.append(device);
+            qCDebug(KSANECORE_LOG) << "Adding device " << device->vendor() << device->name() << device->model() << device->type() << " to device list";
+        } else {
+            qCDebug(KSANECORE_LOG) << "Ignoring device type" << type;
         }
+        i++;
     }
+    return true;
+}
+
+void FindSaneDevicesThread::updateDevicesList(QList<DeviceInformation *> &foundDevices, Interface::DeviceType deviceType, bool complete)
+{
+    QMutexLocker<QMutex> locker(&m_listMutex);
+    // the removed devices of the last refresh are not referenced by any signal anymore
+    qDeleteAll(m_removedDeviceList);
+    m_removedDeviceList.clear();
+    m_addedDevices.clear();
+    m_removedDevices.clear();
+
+    // keep the objects of unchanged devices
+    QList<DeviceInformation *> previousDevices = m_deviceList;
+    for (auto &device : foundDevices) {
+        const auto it = std::find_if(previousDevices.begin(), previousDevices.end(), [device](const DeviceInformation *previous) {
+            return isSameDevice(device, previous);
+        });
+        if (it != previousDevices.end()) {
+            delete device;
+            device = *it;
+            previousDevices.erase(it);
+        } else {
+            m_addedDevices.append(device);
+        }
+    }
+
+    if (complete) {
+        for (const auto device : std::as_const(previousDevices)) {
+            m_removedDevices.append(device->name());
+        }
+        m_removedDeviceList = previousDevices;
+        m_deviceList = foundDevices;
+    } else {
+        // a partial query can not tell whether the other devices are gone
+        m_deviceList.append(m_addedDevices);
+    }
+
+    m_devicesListChanged = !m_addedDevices.isEmpty() || !m_removedDevices.isEmpty();
+    m_hasDevicesList = true;
+    m_listDeviceType = deviceType;
 }
 
 QList<DeviceInformation *> FindSaneDevicesThread::devicesList() const
 {
+    QMutexLocker<QMutex> locker(&m_listMutex);
     return m_deviceList;
 }
 
+bool FindSaneDevicesThread::hasDevicesList() const
+{
+    QMutexLocker<QMutex> locker(&m_listMutex);
+    return m_hasDevicesList && m_listDeviceType == m_deviceType;
+}
+
 void FindSaneDevicesThread::setDeviceType(const Interface::DeviceType type)
 {
+    QMutexLocker<QMutex> locker(&m_listMutex);
     m_deviceType = type;
 }
 
+void FindSaneDevicesThread::setDiscoveryTimeout(int msecs)
+{
+    QMutexLocker<QMutex> locker(&m_listMutex);
+    m_discoveryTimeout = msecs;
+}
+
+int FindSaneDevicesThread::discoveryTimeout() const
+{
+    QMutexLocker<QMutex> locker(&m_listMutex);
+    return m_discoveryTimeout;
+}
+
+bool FindSaneDevicesThread::devicesListChanged() const
+{
+    QMutexLocker<QMutex> locker(&m_listMutex);
+    return m_devicesListChanged;
+}
+
+QList<DeviceInformation *> FindSaneDevicesThread::addedDevices() const
+{
+    QMutexLocker<QMutex> locker(&m_listMutex);
+    return m_addedDevices;
+}
+
+QStringList FindSaneDevicesThread::removedDevices() const
+{
+    QMutexLocker<QMutex> locker(&m_listMutex);
+    return m_removedDevices;
+}
+
+void FindSaneDevicesThread::setPersistentCacheAge(int maxAge)
+{
+    QMutexLocker<QMutex> locker(&m_listMutex);
+    m_persistentCacheAge = maxAge;
+}
+
+bool FindSaneDevicesThread::loadPersistentCache()
+{
+    QMutexLocker<QMutex> locker(&m_listMutex);
+    if (m_persistentCacheAge <= 0 || m_hasDevicesList) {
+        return false;
+    }
+
+    QFile file(persistentCacheFile());
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    const QJsonObject cache = QJsonDocument::fromJson(file.readAll()).object();
+    const qint64 age = QDateTime::currentSecsSinceEpoch() - cache.value(QStringLiteral("timestamp")).toInteger();
+    if (age < 0 || age > m_persistentCacheAge || cache.value(QStringLiteral("deviceType")).toInt() != m_deviceType) {
+        qCDebug(KSANECORE_LOG) << "Ignoring outdated devices list cache";
+        return false;
+    }
+
+    const QJsonArray devices = cache.value(QStringLiteral("devices")).toArray();
+    for (const auto &value : devices) {
+        const QJsonObject device = value.toObject();
+        m_deviceList.append(new InternalDeviceInformation(device.value(QStringLiteral("name")).toString(),
+                                                          device.value(QStringLiteral("vendor")).toString(),
+                                                          device.value(QStringLiteral("model")).toString(),
+                                                          device.value(QStringLiteral("type")).toString()));
+    }
+    m_hasDevicesList = true;
+    m_devicesListChanged = false;
+    m_listDeviceType = m_deviceType;
+    return true;
+}
+
+void FindSaneDevicesThread::savePersistentCache()
+{
+    QMutexLocker<QMutex> locker(&m_listMutex);
+    if (m_persistentCacheAge <= 0) {
+        return;
+    }
+
+    QJsonArray devices;
+    for (const auto device : std::as_const(m_deviceList)) {
+        devices.append(QJsonObject{
+            {QStringLiteral("name"), device->name()},
+            {QStringLiteral("vendor"), device->vendor()},
+            {QStringLiteral("model"), device->model()},
+            {QStringLiteral("type"), device->type()},
+        });
+    }
+    const QJsonObject cache{
+        {QStringLiteral("timestamp"), QDateTime::currentSecsSinceEpoch()},
+        {QStringLiteral("deviceType"), static_cast<int>(m_listDeviceType)},
+        {QStringLiteral("devices"), devices},
+    };
+    locker.unlock();
+
+    const QString fileName = persistentCacheFile();
+    QDir().mkpath(QFileInfo(fileName).absolutePath());
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qCDebug(KSANECORE_LOG) << "Could not write the devices list cache" << fileName;
+        return;
+    }
+    file.write(QJsonDocument(cache).toJson(QJsonDocument::Compact));
+}
+
 } // namespace KSaneCore
 
 #include "moc_finddevicesthread.cpp"
@@ -13,10 +13,17 @@
 
 #include <QThread>
 #include <QList>
+#include <QMutex>
+#include <QStringList>
 
 namespace KSaneCore
 {
 
+/* Keeps the last known devices list which is refreshed in the background by run().
+ * Devices which did not change keep their DeviceInformation object, removed devices
+ * are deleted with the next refresh. The list can be persisted in the user's cache.
+ * With a discovery timeout, the local devices are queried and reported first, as
+ * the network backends may take a long time to answer. */
 class FindSaneDevicesThread : public QThread
 {
     Q_OBJECT
@@ -27,13 +34,39 @@ public:
     void run() override;
 
     QList<DeviceInformation *> devicesList() const;
+    bool hasDevicesList() const;
     void setDeviceType(const Interface::DeviceType type);
+    void setDiscoveryTimeout(int msecs);
+    int discoveryTimeout() const;
+
+    // changes made by the last refresh
+    bool devicesListChanged() const;
+    QList<DeviceInformation *> addedDevices() const;
+    QStringList removedDevices() const;
+
+    void setPersistentCacheAge(int maxAge);
+    bool loadPersistentCache();
+
+Q_SIGNALS:
+    void localDevicesFound(const QList<DeviceInformation *> &addedDevices);
 
 private:
     FindSaneDevicesThread();
+    bool queryDevices(bool localOnly, Interface::DeviceType deviceType, QList<DeviceInformation *> &foundDevices);
+    void updateDevicesList(QList<DeviceInformation *> &foundDevices, Interface::DeviceType deviceType, bool complete);
+    void savePersistentCache();
 
+    mutable QMutex m_listMutex;
     QList<DeviceInformation *> m_deviceList;
+    QList<DeviceInformation *> m_addedDevices;
+    QStringList m_removedDevices;
+    QList<DeviceInformation *> m_removedDeviceList;
+    bool m_hasDevicesList = false;
+    bool m_devicesListChanged = false;
     Interface::DeviceType m_deviceType = Interface::AllDevices;
+    Interface::DeviceType m_listDeviceType = Interface::AllDevices;
+    int m_persistentCacheAge = 0;
+    int m_discoveryTimeout = 0;
 };
 
 } // namespace KSaneCore
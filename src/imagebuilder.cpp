@@ -12,6 +12,8 @@
 
 #include <ksanecore_debug.h>
 
+#include "pageanalyzer.h"
+
 namespace KSaneCore
 {
 ImageBuilder::ImageBuilder(QImage *image, int *dpi)
@@ -44,9 +46,9 @@ void ImageBuilder::start(const SANE_Parameters &params)
     } else if (m_params.depth > 8) {
         imageFormat = QImage::Format_RGBX64;
     }
-    // create a new image if necessary
+    // create a new image if necessary, an image which is still in use would be copied by fill()
     if ((m_image->height() != m_params.lines) ||
-            (m_image->width() != m_params.pixels_per_line) || m_image->format() != imageFormat) {
+            (m_image->width() != m_params.pixels_per_line) || m_image->format() != imageFormat || !m_image->isDetached()) {
         // just hope that the frame size is not changed between different frames of the same image.
 
         int pixelLines = m_params.lines;
@@ -63,6 +65,17 @@ void ImageBuilder::start(const SANE_Parameters &params)
         m_image->setDotsPerMeterY(dpm);
     }
     m_image->fill(0xFFFFFFFF);
+    updateBits();
+
+    m_analyzedRows = 0;
+    if (m_analyzer != nullptr) {
+        m_analyzer->start(*m_image, m_params.lines);
+    }
+    // the final size of images from handscanners is only known at the end
+    m_reducedImages.clear();
+    if (m_params.lines > 0) {
+        startReducedImages();
+    }
 }
 
 void ImageBuilder::beginFrame(const SANE_Parameters &params)
@@ -74,7 +87,196 @@ void ImageBuilder::beginFrame(const SANE_Parameters &params)
     m_pixelDataIndex = 0;
 }
 
+inline int ImageBuilder::lookUp8(int channel, int value) const
+{
+    return m_useLookUpTables ? m_lookUpTables8[channel].constData()[value] : value;
+}
+
+inline int ImageBuilder::lookUp16(int channel, int value) const
+{
+    return m_useLookUpTables ? m_lookUpTables16[channel].constData()[value] : value;
+}
+
 bool ImageBuilder::copyToImage(const SANE_Byte readData[], int read_bytes)
+{
+    if (!convertData(readData, read_bytes)) {
+        return false;
+    }
+    // rows of images with separate frames for the colors are only complete at the end
+    if (m_analyzer != nullptr && m_pixelY > m_analyzedRows) {
+        const int endRow = qMin(m_pixelY, m_image->height());
+        m_analyzer->analyzeRows(*m_image, m_analyzedRows, endRow);
+        m_analyzedRows = endRow;
+    }
+    reduceRows(completedRows());
+    return true;
+}
+
+void ImageBuilder::finish()
+{
+    if (m_reducedImages.isEmpty() && !m_reductionFactors.isEmpty()) {
+        startReducedImages();
+    }
+    // the image might have been cropped to the received rows
+    for (int i = 0; i < m_reducedImages.size(); i++) {
+        const int factor = m_pageReductionFactors.at(i);
+        const int height = (m_image->height() + factor - 1) / factor;
+        if (m_reducedImages.at(i).height() > height) {
+            m_reducedImages[i] = m_reducedImages.at(i).copy(0, 0, m_reducedImages.at(i).width(), height);
+            m_reducedRows[i] = qMin(m_reducedRows.at(i), height);
+        }
+    }
+    reduceRows(m_image->height());
+
+    if (m_analyzer == nullptr) {
+        return;
+    }
+    if (m_analyzedRows < m_image->height()) {
+        m_analyzer->analyzeRows(*m_image, m_analyzedRows, m_image->height());
+        m_analyzedRows = m_image->height();
+    }
+    m_analyzer->finish();
+}
+
+void ImageBuilder::setPageAnalyzer(PageAnalyzer *analyzer)
+{
+    m_analyzer = analyzer;
+}
+
+int ImageBuilder::completedRows() const
+{
+    return qMin(m_pixelY, m_image->height());
+}
+
+void ImageBuilder::setReductionFactors(const QList<int> &factors)
+{
+    m_reductionFactors.clear();
+    for (const int factor : factors) {
+        if (factor > 1) {
+            m_reductionFactors.append(factor);
+        }
+    }
+}
+
+const QList<QImage> &ImageBuilder::reducedImages() const
+{
+    return m_reducedImages;
+}
+
+void ImageBuilder::startReducedImages()
+{
+    // averaged monochrome pixels are gray
+    const QImage::Format format = m_image->format() == QImage::Format_Mono ? QImage::Format_Grayscale8 : m_image->format();
+    // changed factors apply to the next page
+    m_pageReductionFactors = m_reductionFactors;
+    m_reducedImages.clear();
+    m_reducedRows.fill(0, m_pageReductionFactors.size());
+    for (const int factor : std::as_const(m_pageReductionFactors)) {
+        // new images, the previous ones might still be in use
+        QImage reduced((m_image->width() + factor - 1) / factor, (m_image->height() + factor - 1) / factor, format);
+        reduced.setDotsPerMeterX(m_image->dotsPerMeterX() / factor);
+        reduced.setDotsPerMeterY(m_image->dotsPerMeterY() / factor);
+        reduced.fill(Qt::white);
+        m_reducedImages.append(reduced);
+    }
+}
+
+void ImageBuilder::reduceRows(int endRow)
+{
+    for (int i = 0; i < m_reducedImages.size(); i++) {
+        const int factor = m_pageReductionFactors.at(i);
+        // the last band of the image may have fewer rows
+        while (m_reducedRows.at(i) < m_reducedImages.at(i).height()
+               && qMin((m_reducedRows.at(i) + 1) * factor, m_image->height()) <= endRow) {
+            reduceRow(i, m_reducedRows.at(i));
+            m_reducedRows[i]++;
+        }
+    }
+}
+
+void ImageBuilder::reduceRow(int index, int reducedRow)
+{
+    const int factor = m_pageReductionFactors.at(index);
+    QImage &reduced = m_reducedImages[index];
+    const int width = m_image->width();
+    const int reducedWidth = reduced.width();
+    const int firstRow = reducedRow * factor;
+    const int endRow = qMin(firstRow + factor, m_image->height());
+    const QImage::Format format = m_image->format();
+    const int channels = format == QImage::Format_RGB32 || format == QImage::Format_RGBX64 ? 3 : 1;
+
+    m_reductionSums.fill(0, reducedWidth * channels);
+    quint64 *sums = m_reductionSums.data();
+    for (int y = firstRow; y < endRow; y++) {
+        const uchar *line = m_image->constScanLine(y);
+        for (int block = 0, x = 0; block < reducedWidth; block++) {
+            const int blockEnd = qMin(x + factor, width);
+            quint64 *blockSums = sums + block * channels;
+            for (; x < blockEnd; x++) {
+                switch (format) {
+                case QImage::Format_Mono:
+                    // a set bit is black
+                    blockSums[0] += (line[x >> 3] >> (7 - (x & 7))) & 1 ? 0 : 0xFF;
+                    break;
+                case QImage::Format_Grayscale8:
+                    blockSums[0] += line[x];
+                    break;
+                case QImage::Format_Grayscale16:
+                    blockSums[0] += reinterpret_cast<const quint16 *>(line)[x];
+                    break;
+                case QImage::Format_RGBX64: {
+                    const QRgba64 pixel = reinterpret_cast<const QRgba64 *>(line)[x];
+                    blockSums[0] += pixel.red();
+                    blockSums[1] += pixel.green();
+                    blockSums[2] += pixel.blue();
+                    break;
+                }
+                default: {
+                    const QRgb pixel = reinterpret_cast<const QRgb *>(line)[x];
+                    blockSums[0] += qRed(pixel);
+                    blockSums[1] += qGreen(pixel);
+                    blockSums[2] += qBlue(pixel);
+                    break;
+                }
+                }
+            }
+        }
+    }
+
+    uchar *reducedLine = reduced.scanLine(reducedRow);
+    for (int block = 0; block < reducedWidth; block++) {
+        const quint64 count = static_cast<quint64>(qMin(factor, width - block * factor)) * (endRow - firstRow);
+        const quint64 *blockSums = sums + block * channels;
+        switch (reduced.format()) {
+        case QImage::Format_Grayscale8:
+            reducedLine[block] = blockSums[0] / count;
+            break;
+        case QImage::Format_Grayscale16:
+            reinterpret_cast<quint16 *>(reducedLine)[block] = blockSums[0] / count;
+            break;
+        case QImage::Format_RGBX64:
+            reinterpret_cast<QRgba64 *>(reducedLine)[block] = QRgba64::fromRgba64(blockSums[0] / count, blockSums[1] / count, blockSums[2] / count, 0xFFFF);
+            break;
+        default:
+            reinterpret_cast<QRgb *>(reducedLine)[block] = qRgb(blockSums[0] / count, blockSums[1] / count, blockSums[2] / count);
+            break;
+        }
+    }
+}
+
+void ImageBuilder::updateBits()
+{
+    // bits() detaches the image once, later writes must not detach it again
+    m_bits = m_image->bits();
+    m_bytesPerLine = m_image->bytesPerLine();
+}
+
+inline uchar *ImageBuilder::imageLine(int y) const
+{
+    return m_bits + y * m_bytesPerLine;
+}
+
+bool ImageBuilder::convertData(const SANE_Byte readData[], int read_bytes)
 {
     switch (m_params.format) {
     case SANE_FRAME_GRAY:
@@ -83,7 +285,7 @@ bool ImageBuilder::copyToImage(const SANE_Byte readData[], int read_bytes)
                 if (m_pixelY >= m_image->height()) {
                     renewImage();
                 }
-                uchar *imageBits = m_image->scanLine(m_pixelY);
+                uchar *imageBits = imageLine(m_pixelY);
                 imageBits[m_pixelX / 8] = readData[i];
                 m_pixelX += 8;
                 if (m_pixelX >= m_params.pixels_per_line) {
@@ -98,8 +300,8 @@ bool ImageBuilder::copyToImage(const SANE_Byte readData[], int read_bytes)
                 if (m_pixelY >= m_image->height()) {
                     renewImage();
                 }
-                uchar *grayScale = m_image->scanLine(m_pixelY);
-                grayScale[m_pixelX] = readData[i];
+                uchar *grayScale = imageLine(m_pixelY);
+                grayScale[m_pixelX] = lookUp8(0, readData[i]);
                 incrementPixelData();
                 m_frameRead++;
             }
@@ -115,8 +317,8 @@ bool ImageBuilder::copyToImage(const SANE_Byte readData[], int read_bytes)
                     if (m_pixelY >= m_image->height()) {
                         renewImage();
                     }
-                    quint16 *grayScale = reinterpret_cast<quint16*>(m_image->scanLine(m_pixelY));
-                    grayScale[m_pixelX] = m_pixelData[0] + (m_pixelData[1] << 8);
+                    quint16 *grayScale = reinterpret_cast<quint16*>(imageLine(m_pixelY));
+                    grayScale[m_pixelX] = lookUp16(0, m_pixelData[0] + (m_pixelData[1] << 8));
                     incrementPixelData();
                 }
                 m_frameRead++;
@@ -137,8 +339,8 @@ bool ImageBuilder::copyToImage(const SANE_Byte readData[], int read_bytes)
                     if (m_pixelY >= m_image->height()) {
                         renewImage();
                     }
-                    QRgb *rgbData = reinterpret_cast<QRgb*>(m_image->scanLine(m_pixelY));
-                    rgbData[m_pixelX] = qRgb(m_pixelData[0], m_pixelData[1], m_pixelData[2]);
+                    QRgb *rgbData = reinterpret_cast<QRgb*>(imageLine(m_pixelY));
+                    rgbData[m_pixelX] = qRgb(lookUp8(0, m_pixelData[0]), lookUp8(1, m_pixelData[1]), lookUp8(2, m_pixelData[2]));
                     incrementPixelData();
                 }
                 m_frameRead++;
@@ -155,10 +357,10 @@ bool ImageBuilder::copyToImage(const SANE_Byte readData[], int read_bytes)
                     if (m_pixelY >= m_image->height()) {
                         renewImage();
                     }
-                    QRgba64 *rgbData = reinterpret_cast<QRgba64*>(m_image->scanLine(m_pixelY));
-                    rgbData[m_pixelX] = QRgba64::fromRgba64((m_pixelData[0] + (m_pixelData[1] << 8)),
-                                                            (m_pixelData[2] + (m_pixelData[3] << 8)),
-                                                            (m_pixelData[4] + (m_pixelData[5] << 8)),
+                    QRgba64 *rgbData = reinterpret_cast<QRgba64*>(imageLine(m_pixelY));
+                    rgbData[m_pixelX] = QRgba64::fromRgba64(lookUp16(0, m_pixelData[0] + (m_pixelData[1] << 8)),
+                                                            lookUp16(1, m_pixelData[2] + (m_pixelData[3] << 8)),
+                                                            lookUp16(2, m_pixelData[4] + (m_pixelData[5] << 8)),
                                                             0xFFFF);
                     incrementPixelData();
                 }
@@ -176,7 +378,7 @@ bool ImageBuilder::copyToImage(const SANE_Byte readData[], int read_bytes)
                 if (index >= m_image->sizeInBytes()) {
                     renewImage();
                 }
-                m_image->bits()[index] = readData[i];
+                m_bits[index] = lookUp8(0, readData[i]);
                 m_frameRead++;
             }
             return true;
@@ -186,7 +388,10 @@ bool ImageBuilder::copyToImage(const SANE_Byte readData[], int read_bytes)
                 if (index >= m_image->sizeInBytes()) {
                     renewImage();
                 }
-                m_image->bits()[index] = readData[i];
+                m_bits[index] = readData[i];
+                if (m_useLookUpTables && m_frameRead % 2 == 1) {
+                    applyLookUpTable16(0, index);
+                }
                 m_frameRead++;
             }
             return true;
@@ -201,7 +406,7 @@ bool ImageBuilder::copyToImage(const SANE_Byte readData[], int read_bytes)
                 if (index >= m_image->sizeInBytes()) {
                     renewImage();
                 }
-                m_image->bits()[index] = readData[i];
+                m_bits[index] = lookUp8(1, readData[i]);
                 m_frameRead++;
             }
             return true;
@@ -211,7 +416,10 @@ bool ImageBuilder::copyToImage(const SANE_Byte readData[], int read_bytes)
                 if (index >= m_image->sizeInBytes()) {
                     renewImage();
                 }
-                m_image->bits()[index] = readData[i];
+                m_bits[index] = readData[i];
+                if (m_useLookUpTables && m_frameRead % 2 == 1) {
+                    applyLookUpTable16(1, index);
+                }
                 m_frameRead++;
             }
             return true;
@@ -226,7 +434,7 @@ bool ImageBuilder::copyToImage(const SANE_Byte readData[], int read_bytes)
                 if (index >= m_image->sizeInBytes()) {
                     renewImage();
                 }
-                m_image->bits()[index] = readData[i];
+                m_bits[index] = lookUp8(2, readData[i]);
                 m_frameRead++;
             }
             return true;
@@ -236,7 +444,10 @@ bool ImageBuilder::copyToImage(const SANE_Byte readData[], int read_bytes)
                 if (index >= m_image->sizeInBytes()) {
                     renewImage();
                 }
-                m_image->bits()[index] = readData[i];
+                m_bits[index] = readData[i];
+                if (m_useLookUpTables && m_frameRead % 2 == 1) {
+                    applyLookUpTable16(2, index);
+                }
                 m_frameRead++;
             }
             return true;
@@ -255,9 +466,10 @@ void ImageBuilder::renewImage()
 
     // resize the image
     *m_image = m_image->copy(0, 0, m_image->width(), m_image->height() + m_image->width());
+    updateBits();
 
     for (int i = start; i < m_image->sizeInBytes(); i++) { // New parts are filled with "transparent black"
-        m_image->bits()[i] = 0xFF; // Change to opaque white (0xFFFFFFFF), or white, whatever the format is
+        m_bits[i] = 0xFF; // Change to opaque white (0xFFFFFFFF), or white, whatever the format is
     }
 }
 
@@ -267,6 +479,33 @@ void ImageBuilder::cropImagetoSize()
     if (m_image->height() == height)
         return;
     *m_image = m_image->copy(0, 0, m_image->width(), height);
+    updateBits();
+}
+
+void ImageBuilder::setLookUpTables(const std::array<QVector<quint8>, 3> &tables8, const std::array<QVector<quint16>, 3> &tables16)
+{
+    m_useLookUpTables = true;
+    for (int i = 0; i < 3; i++) {
+        if (tables8[i].size() != 256 || tables16[i].size() != 65536) {
+            m_useLookUpTables = false;
+        }
+    }
+    if (m_useLookUpTables) {
+        m_lookUpTables8 = tables8;
+        m_lookUpTables16 = tables16;
+    } else {
+        m_lookUpTables8 = {};
+        m_lookUpTables16 = {};
+    }
+}
+
+void ImageBuilder::applyLookUpTable16(int channel, int index)
+{
+    // the high byte of the value has been written last
+    uchar *bits = m_bits;
+    const int value = m_lookUpTables16[channel].constData()[bits[index - 1] + (bits[index] << 8)];
+    bits[index - 1] = value & 0xFF;
+    bits[index] = value >> 8;
 }
 
 void ImageBuilder::incrementPixelData()
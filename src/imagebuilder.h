@@ -14,11 +14,17 @@ extern "C"
 #include <sane/sane.h>
 }
 
-class QImage;
+#include <array>
+
+#include <QImage>
+#include <QList>
+#include <QVector>
 
 namespace KSaneCore
 {
 
+class PageAnalyzer;
+
 /* Constructs a QImage out of the raw scanned data retrieved via libsane */
 class ImageBuilder
 {
@@ -28,12 +34,34 @@ public:
     void start(const SANE_Parameters &params);
     void beginFrame(const SANE_Parameters &params);
     bool copyToImage(const SANE_Byte readData[], int read_bytes);
+    /* Analyzes the remaining rows once the image is complete */
+    void finish();
     void setDPI(int dpi);
     void cropImagetoSize();
+    /* Per channel tables which are applied to the pixel values, gray images use the first table.
+     * The 8-bit tables have 256 entries, the 16-bit tables 65536. Empty tables disable them. */
+    void setLookUpTables(const std::array<QVector<quint8>, 3> &tables8, const std::array<QVector<quint16>, 3> &tables16);
+    /* The analyzer gets every row as soon as it is complete */
+    void setPageAnalyzer(PageAnalyzer *analyzer);
+    /* The number of rows which are complete and are not written again */
+    int completedRows() const;
+    /* Builds reduced images alongside the full image, their width and height are divided by the factors.
+     * Every pixel is the average of a block of pixels, a band of rows is reduced as soon as it is complete. */
+    void setReductionFactors(const QList<int> &factors);
+    const QList<QImage> &reducedImages() const;
 
 private:
+    bool convertData(const SANE_Byte readData[], int read_bytes);
     void renewImage();
+    void updateBits();
+    uchar *imageLine(int y) const;
+    void startReducedImages();
+    void reduceRows(int endRow);
+    void reduceRow(int index, int reducedRow);
     void incrementPixelData();
+    int lookUp8(int channel, int value) const;
+    int lookUp16(int channel, int value) const;
+    void applyLookUpTable16(int channel, int index);
 
     SANE_Parameters m_params;
     int m_frameRead = 0;
@@ -42,7 +70,25 @@ private:
     int m_pixelData[6];
     int m_pixelDataIndex = 0;
 
+    std::array<QVector<quint8>, 3> m_lookUpTables8;
+    std::array<QVector<quint16>, 3> m_lookUpTables16;
+    bool m_useLookUpTables = false;
+
+    PageAnalyzer *m_analyzer = nullptr;
+    int m_analyzedRows = 0;
+
+    QList<int> m_reductionFactors;
+    QList<int> m_pageReductionFactors;
+    QList<QImage> m_reducedImages;
+    // the number of complete rows of each reduced image
+    QList<int> m_reducedRows;
+    QVector<quint64> m_reductionSums;
+
     QImage *m_image;
+    // the rows are written through this pointer, so that images sharing the completed rows,
+    // e.g. the regions of a region scan, do not cause a copy of the whole image
+    uchar *m_bits = nullptr;
+    qsizetype m_bytesPerLine = 0;
     int *m_dpi;
 };
 
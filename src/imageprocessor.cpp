@@ -0,0 +1,202 @@
+/*
+ * SPDX-FileCopyrightText: 2026 KSaneCore developers
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+ */
+
+#include "imageprocessor.h"
+
+#include <cstring>
+
+#include <QSemaphore>
+#include <QThread>
+#include <QThreadPool>
+#include <QtMath>
+
+// bands smaller than this are not worth a task of their own
+static const int MINIMUM_BAND_ROWS = 64;
+
+namespace KSaneCore
+{
+
+void ImageProcessor::processRows(int rows, const std::function<void(int firstRow, int endRow)> &function)
+{
+    const int bands = qBound(1, rows / MINIMUM_BAND_ROWS, QThread::idealThreadCount());
+    if (bands == 1) {
+        function(0, rows);
+        return;
+    }
+
+    QSemaphore bandsDone;
+    const int bandRows = (rows + bands - 1) / bands;
+    // the last band is processed by the calling thread
+    for (int band = 0; band < bands - 1; band++) {
+        const int firstRow = band * bandRows;
+        const int endRow = firstRow + bandRows;
+        QThreadPool::globalInstance()->start([&function, &bandsDone, firstRow, endRow]() {
+            function(firstRow, endRow);
+            bandsDone.release();
+        });
+    }
+    function((bands - 1) * bandRows, rows);
+    bandsDone.acquire(bands - 1);
+}
+
+QImage ImageProcessor::convertToGrayscale(const QImage &image)
+{
+    const bool deep = image.format() == QImage::Format_RGBX64;
+    QImage grayImage(image.width(), image.height(), deep ? QImage::Format_Grayscale16 : QImage::Format_Grayscale8);
+    grayImage.setDotsPerMeterX(image.dotsPerMeterX());
+    grayImage.setDotsPerMeterY(image.dotsPerMeterY());
+    const int width = image.width();
+    // scanLine() must not be called concurrently, it detaches the image
+    uchar *grayBits = grayImage.bits();
+    const qsizetype grayBytesPerLine = grayImage.bytesPerLine();
+
+    processRows(image.height(), [&](int firstRow, int endRow) {
+        for (int y = firstRow; y < endRow; y++) {
+            if (deep) {
+                const QRgba64 *pixels = reinterpret_cast<const QRgba64 *>(image.constScanLine(y));
+                quint16 *grayPixels = reinterpret_cast<quint16 *>(grayBits + y * grayBytesPerLine);
+                for (int x = 0; x < width; x++) {
+                    // same weights as qGray()
+                    grayPixels[x] = (pixels[x].red() * 11 + pixels[x].green() * 16 + pixels[x].blue() * 5) / 32;
+                }
+            } else {
+                const QRgb *pixels = reinterpret_cast<const QRgb *>(image.constScanLine(y));
+                uchar *grayPixels = grayBits + y * grayBytesPerLine;
+                for (int x = 0; x < width; x++) {
+                    grayPixels[x] = qGray(pixels[x]);
+                }
+            }
+        }
+    });
+    return grayImage;
+}
+
+QImage ImageProcessor::convertToMono(const QImage &image)
+{
+    if (image.format() == QImage::Format_Mono) {
+        return image;
+    }
+
+    QImage monoImage(image.width(), image.height(), QImage::Format_Mono);
+    monoImage.setColorTable(QVector<QRgb>({0xFFFFFFFF, 0xFF000000}));
+    monoImage.setDotsPerMeterX(image.dotsPerMeterX());
+    monoImage.setDotsPerMeterY(image.dotsPerMeterY());
+    const int width = image.width();
+    const QImage::Format format = image.format();
+    // scanLine() must not be called concurrently, it detaches the image
+    uchar *monoBits = monoImage.bits();
+    const qsizetype monoBytesPerLine = monoImage.bytesPerLine();
+
+    processRows(image.height(), [&](int firstRow, int endRow) {
+        for (int y = firstRow; y < endRow; y++) {
+            const uchar *line = image.constScanLine(y);
+            uchar *monoLine = monoBits + y * monoBytesPerLine;
+            memset(monoLine, 0, monoBytesPerLine);
+            for (int x = 0; x < width; x++) {
+                bool black;
+                switch (format) {
+                case QImage::Format_Grayscale8:
+                    black = line[x] < 0x80;
+                    break;
+                case QImage::Format_Grayscale16:
+                    black = reinterpret_cast<const quint16 *>(line)[x] < 0x8000;
+                    break;
+                case QImage::Format_RGBX64: {
+                    const QRgba64 pixel = reinterpret_cast<const QRgba64 *>(line)[x];
+                    black = (pixel.red() * 11 + pixel.green() * 16 + pixel.blue() * 5) / 32 < 0x8000;
+                    break;
+                }
+                default:
+                    black = qGray(reinterpret_cast<const QRgb *>(line)[x]) < 0x80;
+                    break;
+                }
+                if (black) {
+                    monoLine[x >> 3] |= 0x80 >> (x & 7);
+                }
+            }
+        }
+    });
+    return monoImage;
+}
+
+QImage ImageProcessor::subImage(const QImage &image, const QRect &area)
+{
+    QRect subArea = area.intersected(image.rect());
+    if (subArea.isEmpty() || subArea == image.rect()) {
+        return image;
+    }
+    if (image.depth() == 1) {
+        subArea.setLeft(subArea.left() & ~7);
+    }
+
+    // the copy shares the data and keeps it alive until the sub image is destroyed
+    QImage *source = new QImage(image);
+    const uchar *data = source->constBits() + subArea.top() * source->bytesPerLine() + subArea.left() * source->depth() / 8;
+    QImage sub(
+        data,
+        subArea.width(),
+        subArea.height(),
+        source->bytesPerLine(),
+        source->format(),
+        [](void *info) {
+            delete static_cast<QImage *>(info);
+        },
+        source);
+    sub.setColorTable(image.colorTable());
+    sub.setDotsPerMeterX(image.dotsPerMeterX());
+    sub.setDotsPerMeterY(image.dotsPerMeterY());
+    return sub;
+}
+
+QImage ImageProcessor::deskew(const QImage &image, double angle)
+{
+    QImage rotated(image.size(), image.format());
+    rotated.setColorTable(image.colorTable());
+    rotated.setDotsPerMeterX(image.dotsPerMeterX());
+    rotated.setDotsPerMeterY(image.dotsPerMeterY());
+    rotated.fill(QColor(Qt::white));
+
+    const int width = image.width();
+    const int height = image.height();
+    const int bytesPerPixel = image.depth() / 8;
+    const bool mono = image.depth() == 1;
+    const double cosine = qCos(qDegreesToRadians(angle));
+    const double sine = qSin(qDegreesToRadians(angle));
+    const double centerX = width / 2.0;
+    const double centerY = height / 2.0;
+    const uchar *sourceBits = image.constBits();
+    const qsizetype sourceBytesPerLine = image.bytesPerLine();
+    // scanLine() must not be called concurrently, it detaches the image
+    uchar *rotatedBits = rotated.bits();
+    const qsizetype rotatedBytesPerLine = rotated.bytesPerLine();
+
+    processRows(height, [&](int firstRow, int endRow) {
+        for (int y = firstRow; y < endRow; y++) {
+            uchar *line = rotatedBits + y * rotatedBytesPerLine;
+            // the source position moves along a straight line
+            double sourceX = centerX - centerX * cosine - (y - centerY) * sine;
+            double sourceY = centerY - centerX * sine + (y - centerY) * cosine;
+            for (int x = 0; x < width; x++, sourceX += cosine, sourceY += sine) {
+                const int sx = qFloor(sourceX + 0.5);
+                const int sy = qFloor(sourceY + 0.5);
+                if (sx < 0 || sy < 0 || sx >= width || sy >= height) {
+                    continue;
+                }
+                const uchar *sourceLine = sourceBits + sy * sourceBytesPerLine;
+                if (mono) {
+                    if (sourceLine[sx >> 3] & (0x80 >> (sx & 7))) {
+                        line[x >> 3] |= 0x80 >> (x & 7);
+                    }
+                } else {
+                    memcpy(line + x * bytesPerPixel, sourceLine + sx * bytesPerPixel, bytesPerPixel);
+                }
+            }
+        }
+    });
+    return rotated;
+}
+
+} // namespace KSaneCore
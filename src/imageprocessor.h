@@ -0,0 +1,44 @@
+/*
+ * SPDX-FileCopyrightText: 2026 KSaneCore developers
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+ */
+
+#ifndef KSANE_IMAGE_PROCESSOR_H
+#define KSANE_IMAGE_PROCESSOR_H
+
+#include <functional>
+
+#include <QImage>
+
+namespace KSaneCore
+{
+
+/* Operations on complete scanned images. They process bands of rows in parallel
+ * and handle the image formats created by the ImageBuilder. */
+class ImageProcessor
+{
+public:
+    /* Calls the function for bands of rows [firstRow, endRow) on the global thread pool
+     * and returns when all bands are done */
+    static void processRows(int rows, const std::function<void(int firstRow, int endRow)> &function);
+
+    /* Converts a color image to Grayscale8 or to Grayscale16 for images with 16 bits per channel */
+    static QImage convertToGrayscale(const QImage &image);
+
+    /* Converts an image to Mono, pixels darker than half of the maximum value become black */
+    static QImage convertToMono(const QImage &image);
+
+    /* Returns the area of the image without copying the data, the returned image refers to the data
+     * of the image and keeps it alive. The left edge of monochrome images is aligned to full bytes. */
+    static QImage subImage(const QImage &image, const QRect &area);
+
+    /* Rotates the image around its center by the given angle in degrees counterclockwise,
+     * which removes a clockwise skew. The pixels are sampled from the nearest source pixel,
+     * areas outside of the source image are white. */
+    static QImage deskew(const QImage &image, double angle);
+};
+
+} // namespace KSaneCore
+
+#endif // KSANE_IMAGE_PROCESSOR_H
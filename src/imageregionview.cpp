@@ -0,0 +1,85 @@
+/*
+ * SPDX-FileCopyrightText: 2026 KSaneCore developers
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+ */
+
+#include "imageregionview.h"
+
+#include <QMutexLocker>
+
+#include "imageprocessor.h"
+
+namespace KSaneCore
+{
+
+void ImageRegionView::start(const QImage &image)
+{
+    QMutexLocker locker(&m_mutex);
+    m_image = image;
+    m_completedRows = 0;
+}
+
+void ImageRegionView::replaceImage(const QImage &image)
+{
+    QMutexLocker locker(&m_mutex);
+    m_image = image;
+    m_completedRows = qMin(m_completedRows, image.height());
+}
+
+void ImageRegionView::clear()
+{
+    // the image is released, so that it is not copied when it is written again
+    QMutexLocker locker(&m_mutex);
+    m_image = QImage();
+    m_completedRows = 0;
+}
+
+void ImageRegionView::setCompletedRows(int rows)
+{
+    QMutexLocker locker(&m_mutex);
+    m_completedRows = qMin(rows, m_image.height());
+}
+
+int ImageRegionView::columns() const
+{
+    QMutexLocker locker(&m_mutex);
+    return (m_image.width() + TILE_SIZE - 1) / TILE_SIZE;
+}
+
+int ImageRegionView::completedTileRows() const
+{
+    QMutexLocker locker(&m_mutex);
+    return completedTileRowsLocked();
+}
+
+int ImageRegionView::completedTileRowsLocked() const
+{
+    // the last tile row is shorter than the others
+    if (!m_image.isNull() && m_completedRows == m_image.height()) {
+        return (m_completedRows + TILE_SIZE - 1) / TILE_SIZE;
+    }
+    return m_completedRows / TILE_SIZE;
+}
+
+QImage ImageRegionView::tile(int column, int row) const
+{
+    QMutexLocker locker(&m_mutex);
+    const QRect area = QRect(column * TILE_SIZE, row * TILE_SIZE, TILE_SIZE, TILE_SIZE).intersected(m_image.rect());
+    if (column < 0 || row < 0 || area.isEmpty() || row >= completedTileRowsLocked()) {
+        return QImage();
+    }
+    return ImageProcessor::subImage(m_image, area);
+}
+
+QImage ImageRegionView::region(const QRect &area) const
+{
+    QMutexLocker locker(&m_mutex);
+    const QRect imageArea = area.intersected(m_image.rect());
+    if (imageArea.isEmpty() || imageArea.bottom() >= m_completedRows) {
+        return QImage();
+    }
+    return ImageProcessor::subImage(m_image, imageArea);
+}
+
+} // namespace KSaneCore
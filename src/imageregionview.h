@@ -0,0 +1,49 @@
+/*
+ * SPDX-FileCopyrightText: 2026 KSaneCore developers
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+ */
+
+#ifndef KSANE_IMAGE_REGION_VIEW_H
+#define KSANE_IMAGE_REGION_VIEW_H
+
+#include <QImage>
+#include <QMutex>
+
+namespace KSaneCore
+{
+
+/* Hands out views of the completed rows of an image while it is being received, either as
+ * regions or as cells of a grid of TILE_SIZE x TILE_SIZE pixels. The rows which are complete are
+ * not written again, so the views share the data of the image without copying it and keep it
+ * alive. Only the bookkeeping is locked, not the image.
+ * This is not a tiled backing store: the image is still allocated as one contiguous QImage. */
+class ImageRegionView
+{
+public:
+    static const int TILE_SIZE = 256;
+
+    void start(const QImage &image);
+    /* Replaces the image by one with the same content of the completed rows */
+    void replaceImage(const QImage &image);
+    void clear();
+    void setCompletedRows(int rows);
+
+    int columns() const;
+    int completedTileRows() const;
+    /* A tile is null until all of its rows are complete */
+    QImage tile(int column, int row) const;
+    /* A region is null until all of its rows are complete */
+    QImage region(const QRect &area) const;
+
+private:
+    int completedTileRowsLocked() const;
+
+    mutable QMutex m_mutex;
+    QImage m_image;
+    int m_completedRows = 0;
+};
+
+} // namespace KSaneCore
+
+#endif // KSANE_IMAGE_REGION_VIEW_H
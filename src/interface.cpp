@@ -25,6 +25,7 @@ extern "C" {
 
 #include "interface.h"
 #include "interface_p.h"
+#include "gammaoption.h"
 
 #include <ksanecore_debug.h>
 
@@ -60,6 +61,7 @@ Interface::Interface(QObject *parent)
 Interface::~Interface()
 {
     closeDevice();
+    d->releaseParkedDevice();
 
     s_objectMutex->lock();
     s_objectCount--;
@@ -93,19 +95,59 @@ void Interface::setPreviewResolution(float dpi)
     d->m_previewDPI = dpi;
 }
 
+void Interface::setAsynchronousOptionAccess(bool enable)
+{
+    d->m_asynchronousOptionAccess = enable;
+    if (d->m_optionWorker != nullptr) {
+        d->m_optionWorker->setAsynchronous(enable);
+    }
+}
+
+void Interface::setGammaWriteDelay(int msecs)
+{
+    d->m_gammaWriteDelay = msecs;
+    for (BaseOption *option : std::as_const(d->m_optionsList)) {
+        if (GammaOption *gammaOption = qobject_cast<GammaOption *>(option)) {
+            gammaOption->setWriteDelay(msecs);
+        }
+    }
+}
+
 bool Interface::reloadDevicesList(const DeviceType type)
 {
     /* On some SANE backends, the handle becomes invalid when
      * querying for new devices. Hence, this is only allowed when
      * no device is currently opened. */
     if (d->m_saneHandle == nullptr) {
+        // the handle of a kept device might become invalid as well
+        d->releaseParkedDevice();
         d->m_findDevThread->setDeviceType(type);
+        // report the last known devices right away, they are refreshed in the background
+        if (d->m_findDevThread->hasDevicesList() || d->m_findDevThread->loadPersistentCache()) {
+            d->m_devicesListRequested = false;
+            QMetaObject::invokeMethod(d.get(), &InterfacePrivate::signalCachedDevicesList, Qt::QueuedConnection);
+        } else {
+            d->m_devicesListRequested = true;
+            if (d->m_findDevThread->discoveryTimeout() > 0) {
+                d->m_discoveryTimer.start(d->m_findDevThread->discoveryTimeout());
+            }
+        }
         d->m_findDevThread->start();
         return true;
     }
     return false;
 }
 
+void Interface::setDevicesListCacheAge(int maxAge)
+{
+    d->m_findDevThread->setPersistentCacheAge(maxAge);
+}
+
+void Interface::setDeviceDiscoveryTimeout(int msecs)
+{
+    d->m_findDevThread->setDiscoveryTimeout(msecs);
+}
+
 Interface::OpenStatus Interface::openDevice(const QString &deviceName)
 {
     SANE_Status status;
@@ -119,6 +161,9 @@ Interface::OpenStatus Interface::openDevice(const QString &deviceName)
     if (deviceName.isEmpty()) {
         return OpenStatus::OpeningFailed;
     }
+    if (d->reopenParkedDevice(deviceName)) {
+        return OpenStatus::OpeningSucceeded;
+    }
     // save the device name
     d->m_devName = deviceName;
 
@@ -151,6 +196,9 @@ Interface::OpenStatus Interface::openRestrictedDevice(const QString &deviceName,
     if (deviceName.isEmpty()) {
         return OpenStatus::OpeningFailed;
     }
+    if (d->reopenParkedDevice(deviceName)) {
+        return OpenStatus::OpeningSucceeded;
+    }
     // save the device name
     d->m_devName = deviceName;
 
@@ -180,22 +228,132 @@ bool Interface::closeDevice()
         return false;
     }
     stopScan();
+    // a cancelled scan might still be running, its job is cancelled as well
+    d->m_currentScanJob = InterfacePrivate::ScanJob();
 
-    disconnect(d->m_scanThread);
-    if (d->m_scanThread->isRunning()) {
-        connect(d->m_scanThread, &QThread::finished, d->m_scanThread, &QThread::deleteLater);
+    if (!d->parkDevice()) {
+        d->releaseDevice();
     }
-    if (d->m_scanThread->isFinished()) {
-        d->m_scanThread->deleteLater();
+    return true;
+}
+
+void Interface::setDeviceKeepAliveTime(int msecs)
+{
+    d->m_keepAliveTime = msecs;
+    if (msecs <= 0) {
+        d->releaseParkedDevice();
     }
-    d->m_scanThread = nullptr;
+}
 
-    d->m_auth->clearDeviceAuth(d->m_devName);
-    sane_close(d->m_saneHandle);
-    d->m_saneHandle = nullptr;
-    d->clearDeviceOptions();
+void Interface::setScanThreadPriority(QThread::Priority priority)
+{
+    d->m_scanThreadPriority = priority;
+    if (d->m_scanThread != nullptr) {
+        d->m_scanThread->setReaderPriority(priority);
+    }
+}
 
-    return true;
+void Interface::setScanThreadAffinity(const QList<int> &cpus)
+{
+    d->m_scanThreadAffinity = cpus;
+    if (d->m_scanThread != nullptr) {
+        d->m_scanThread->setReaderAffinity(cpus);
+    }
+}
+
+void Interface::setScanProgressThresholds(int percentStep, int minimumInterval)
+{
+    d->m_progressStep = percentStep;
+    d->m_progressInterval = minimumInterval;
+    if (d->m_scanThread != nullptr) {
+        d->m_scanThread->setProgressThresholds(percentStep, minimumInterval);
+    }
+}
+
+void Interface::setMaximumPendingPages(int pages)
+{
+    d->m_maxPendingPages = pages;
+    if (d->m_scanThread != nullptr) {
+        d->m_scanThread->setMaximumPendingPages(pages);
+    }
+}
+
+void Interface::setBlankPageDetection(double maximumInkRatio, int marginPercent)
+{
+    d->m_blankPageInkRatio = maximumInkRatio;
+    d->m_blankPageMargin = marginPercent;
+    if (d->m_scanThread != nullptr) {
+        d->m_scanThread->setBlankPageDetection(maximumInkRatio, marginPercent);
+    }
+}
+
+void Interface::setSkipBlankPages(bool skip)
+{
+    d->m_skipBlankPages = skip;
+    if (d->m_scanThread != nullptr) {
+        d->m_scanThread->setSkipBlankPages(skip);
+    }
+}
+
+void Interface::setAutomaticColorReduction(bool enable)
+{
+    d->m_reduceColors = enable;
+    if (d->m_scanThread != nullptr) {
+        d->m_scanThread->setAutomaticColorReduction(enable);
+    }
+}
+
+void Interface::setAutomaticCrop(bool enable)
+{
+    d->m_cropToContent = enable;
+    if (d->m_scanThread != nullptr) {
+        d->m_scanThread->setAutomaticCrop(enable);
+    }
+}
+
+void Interface::setAdjustScanAreaToContent(bool enable)
+{
+    d->m_adjustScanArea = enable;
+}
+
+void Interface::setReductionFactors(const QList<int> &factors)
+{
+    d->m_reductionFactors = factors;
+    if (d->m_scanThread != nullptr) {
+        d->m_scanThread->setReductionFactors(factors);
+    }
+}
+
+void Interface::setPageHashing(bool enable)
+{
+    d->m_pageHashing = enable;
+    if (d->m_scanThread != nullptr) {
+        d->m_scanThread->setPageHashing(d->pageHashingEnabled());
+    }
+}
+
+void Interface::setDuplicatePageDetection(int pages, int maximumDistance)
+{
+    d->m_duplicatePageDetector.setDetection(pages, maximumDistance);
+    if (d->m_scanThread != nullptr) {
+        d->m_scanThread->setPageHashing(d->pageHashingEnabled());
+    }
+}
+
+void Interface::setReusePreviewScan(bool enable)
+{
+    d->m_reusePreviewScan = enable;
+    if (!enable) {
+        d->m_previewCache = InterfacePrivate::PreviewCache();
+    }
+}
+
+void Interface::setAutomaticDeskew(bool enable)
+{
+    d->m_deskew = enable;
+    if (d->m_scanThread != nullptr) {
+        d->m_scanThread->setAutomaticDeskew(enable);
+    }
 }
 
 void Interface::startScan()
@@ -204,14 +362,23 @@ void Interface::startScan()
         return;
     }
     d->m_cancelMultiPageScan = false;
+    // the scan has to use the latest gamma tables
+    d->writePendingGammaTables();
     // execute a pending value reload
     while (d->m_readValuesTimer.isActive()) {
         d->m_readValuesTimer.stop();
         d->reloadValues();
     }
-    d->m_optionPollTimer.stop();
+    // a compatible scan is cropped from the last preview without scanning again
+    if (d->servePreviewCache()) {
+        return;
+    }
+    // a running poll is finished before the scan thread is started
+    d->m_optionWorker->setPollingEnabled(false);
+    d->m_scanThread->resetStatistics();
+    d->m_duplicatePageCount = 0;
     d->emitProgress(-1);
-    d->m_scanThread->start();
+    d->startScanThread();
 }
 
 void Interface::startPreviewScan()
@@ -297,21 +464,139 @@ void Interface::startPreviewScan()
     startScan();
 }
 
+bool Interface::startRegionScan(const QList<QRectF> &regions)
+{
+    Option *topLeftXOption = getOption(Interface::TopLeftXOption);
+    Option *topLeftYOption = getOption(Interface::TopLeftYOption);
+    Option *bottomRightXOption = getOption(Interface::BottomRightXOption);
+    Option *bottomRightYOption = getOption(Interface::BottomRightYOption);
+    if (!d->m_saneHandle || d->isScanning() || regions.isEmpty() || topLeftXOption == nullptr || topLeftYOption == nullptr
+        || bottomRightXOption == nullptr || bottomRightYOption == nullptr) {
+        return false;
+    }
+
+    // the regions are mapped to pixels of the scanned image
+    double pixelsPerUnitX = 1;
+    double pixelsPerUnitY = 1;
+    if (topLeftXOption->valueUnit() == Option::UnitMilliMeter) {
+        const QSizeF resolution = d->scanResolution();
+        if (resolution.isEmpty()) {
+            return false;
+        }
+        pixelsPerUnitX = resolution.width() / 25.4;
+        pixelsPerUnitY = resolution.height() / 25.4;
+    } else if (topLeftXOption->valueUnit() != Option::UnitPixel) {
+        return false;
+    }
+
+    QRectF scanArea;
+    for (const QRectF &region : regions) {
+        scanArea = scanArea.united(region.normalized());
+    }
+    scanArea &= QRectF(QPointF(topLeftXOption->minimumValue().toDouble(), topLeftYOption->minimumValue().toDouble()),
+                       QPointF(bottomRightXOption->maximumValue().toDouble(), bottomRightYOption->maximumValue().toDouble()));
+    if (scanArea.isEmpty()) {
+        return false;
+    }
+
+    QList<QRect> pixelRegions;
+    for (const QRectF &region : regions) {
+        const QRectF area = region.normalized();
+        pixelRegions.append(QRectF((area.left() - scanArea.left()) * pixelsPerUnitX,
+                                   (area.top() - scanArea.top()) * pixelsPerUnitY,
+                                   area.width() * pixelsPerUnitX,
+                                   area.height() * pixelsPerUnitY)
+                                .toAlignedRect());
+    }
+
+    // the user values are restored when the scan has finished
+    topLeftXOption->storeCurrentData();
+    topLeftYOption->storeCurrentData();
+    bottomRightXOption->storeCurrentData();
+    bottomRightYOption->storeCurrentData();
+    topLeftXOption->setValue(scanArea.left());
+    topLeftYOption->setValue(scanArea.top());
+    bottomRightXOption->setValue(scanArea.right());
+    bottomRightYOption->setValue(scanArea.bottom());
+
+    d->m_regionScan = true;
+    d->m_scanThread->setScanRegions(pixelRegions);
+    startScan();
+    return true;
+}
+
 void Interface::stopScan()
 {
     if (!d->m_saneHandle) {
         return;
     }
 
-    d->m_cancelMultiPageScan = true;
-    if (d->m_scanThread->isRunning()) {
-        d->m_scanThread->cancelScan();
+    // queued jobs are cancelled when their promises are destroyed
+    d->m_scanJobs.clear();
+    d->stopScanning();
+}
+
+int Interface::queueScanJob(const QMap<QString, QString> &options, int priority)
+{
+    if (!d->m_saneHandle) {
+        return -1;
+    }
+    InterfacePrivate::ScanJob job;
+    job.id = ++d->m_lastScanJobId;
+    job.priority = priority;
+    job.options = options;
+    job.promise = std::make_shared<QPromise<QImage>>();
+    d->enqueueScanJob(std::move(job));
+    // jobs queued in a row are sorted by priority before the first one is started
+    QMetaObject::invokeMethod(d.get(), &InterfacePrivate::startNextScanJob, Qt::QueuedConnection);
+    return d->m_lastScanJobId;
+}
+
+QFuture<QImage> Interface::scanJobFuture(int jobId) const
+{
+    if (jobId > 0 && d->m_currentScanJob.id == jobId) {
+        return d->m_currentScanJob.promise->future();
+    }
+    for (const auto &job : std::as_const(d->m_scanJobs)) {
+        if (job.id == jobId) {
+            return job.promise->future();
+        }
+    }
+    return QFuture<QImage>();
+}
+
+bool Interface::cancelScanJob(int jobId)
+{
+    if (jobId > 0 && d->m_currentScanJob.id == jobId) {
+        // the next job is started when the scan has been stopped
+        d->stopScanning();
+        return true;
     }
-    if (d->m_batchModeTimer.isActive()) {
-        d->m_batchModeTimer.stop();
-        Q_EMIT batchModeCountDown(0);
-        Q_EMIT scanFinished(ScanStatus::NoError, i18n("Scanning stopped by user."));
+    for (int i = 0; i < d->m_scanJobs.size(); i++) {
+        if (d->m_scanJobs.at(i).id == jobId) {
+            d->m_scanJobs.removeAt(i);
+            return true;
+        }
     }
+    return false;
+}
+
+bool Interface::setScanJobPriority(int jobId, int priority)
+{
+    for (int i = 0; i < d->m_scanJobs.size(); i++) {
+        if (d->m_scanJobs.at(i).id == jobId) {
+            InterfacePrivate::ScanJob job = d->m_scanJobs.takeAt(i);
+            job.priority = priority;
+            d->enqueueScanJob(std::move(job));
+            return true;
+        }
+    }
+    return false;
+}
+
+void Interface::setApplyScanJobOptionsEarly(bool enable)
+{
+    d->m_applyScanJobOptionsEarly = enable;
 }
 
 QImage *Interface::scanImage() const
@@ -322,6 +607,30 @@ QImage *Interface::scanImage() const
     return nullptr;
 }
 
+QList<QImage> Interface::reducedScanImages() const
+{
+    if (d->m_saneHandle != nullptr) {
+        return d->m_scanThread->reducedImages();
+    }
+    return {};
+}
+
+QImage Interface::scanTile(int column, int row) const
+{
+    if (d->m_saneHandle != nullptr) {
+        return d->m_scanThread->regionView().tile(column, row);
+    }
+    return QImage();
+}
+
+QImage Interface::scanRegion(const QRect &area) const
+{
+    if (d->m_saneHandle != nullptr) {
+        return d->m_scanThread->regionView().region(area);
+    }
+    return QImage();
+}
+
 void Interface::lockScanImage()
 {
     if (d->m_saneHandle != nullptr) {
@@ -375,6 +684,21 @@ QJsonObject Interface::scannerOptionsToJson()
     return optionData;
 }
 
+QJsonObject Interface::scanStatisticsToJson()
+{
+    if (d->m_saneHandle == nullptr) {
+        return QJsonObject();
+    }
+    QJsonObject statistics;
+    statistics[QLatin1String("scannedPages")] = d->m_scanThread->scannedPages();
+    statistics[QLatin1String("blankPages")] = d->m_scanThread->blankPages();
+    statistics[QLatin1String("duplicatePages")] = d->m_duplicatePageCount;
+    statistics[QLatin1String("stallCount")] = d->m_scanThread->stallCount();
+    statistics[QLatin1String("stallTime")] = d->m_scanThread->stallTime();
+
+    return statistics;
+}
+
 QList<Option *> Interface::getOptionsList()
 {
     return d->m_externalOptionsList;
@@ -415,7 +739,7 @@ QMap<QString, QString> Interface::getOptionsMap()
 
 int Interface::setOptionsMap(const QMap<QString, QString> &options)
 {
-    if (!d->m_saneHandle || d->m_scanThread->isRunning()) {
+    if (!d->m_saneHandle || d->m_scanThread->isScanning()) {
         return -1;
     }
 
@@ -14,10 +14,15 @@
 
 #include <memory>
 
+#include <QFuture>
 #include <QImage>
 #include <QJsonObject>
 #include <QList>
 #include <QObject>
+#include <QRectF>
+#include <QStringList>
+#include <QThread>
+#include <QVariantMap>
 
 #include "deviceinformation.h"
 
@@ -29,6 +34,13 @@ class Option;
 
 /**
  * This class provides the core interface for accessing the scan controls and options.
+ *
+ * Several devices can be used at the same time by creating one Interface per device.
+ * Every Interface has its own scan thread and executes the option accesses of its device
+ * on its own, scanning with one device does not block the others. All Interfaces have to
+ * be created, used and destroyed in the same thread, they share the device discovery.
+ * @note Some SANE backends invalidate open device handles when the devices are queried,
+ * so reloadDevicesList() should not be called while any Interface has an open device.
  */
 class KSANECORE_EXPORT Interface : public QObject
 {
@@ -88,6 +100,7 @@ public:
         WhiteLevelOption,
         BatchModeOption,
         BatchDelayOption,
+        SoftwareGammaOption,
     };
 
     /**
@@ -110,6 +123,10 @@ public:
     /**
      * Get the list of available scanning devices. Connect to availableDevices()
      * which is fired once these devices are known.
+     * If the devices have been queried before or a persistent cache is enabled with
+     * setDevicesListCacheAge(), availableDevices() is fired right away with the last known
+     * devices. The list is refreshed in the background and availableDevices() and
+     * devicesListChanged() are fired again if devices have been added or removed.
      * @note While the querying is done in a separate thread and thus not blocking
      * the application, the application must ensure that no other action accessing
      * the scanner device (settings options etc.) is performed during this period.
@@ -118,6 +135,26 @@ public:
      */
     bool reloadDevicesList(DeviceType type = AllDevices);
 
+    /**
+     * This function enables storing the found devices in the user's cache directory.
+     * reloadDevicesList() then reports the stored devices immediately after the start of
+     * the application, as long as they are not older than the given age.
+     * @param maxAge is the maximum age of the stored devices list in seconds,
+     * 0 disables the persistent cache, which is the default
+     * @since 25.04
+     */
+    void setDevicesListCacheAge(int maxAge);
+
+    /**
+     * This function limits the time reloadDevicesList() waits for slow backends, e.g. unreachable
+     * network scanners. The local devices are queried first and reported as soon as they are found.
+     * If the complete list is not known after the timeout, availableDevices() is fired with the
+     * devices found so far. Devices of slower backends are reported later with devicesListChanged().
+     * @param msecs is the timeout in milliseconds, 0 waits for all backends, which is the default
+     * @since 25.04
+     */
+    void setDeviceDiscoveryTimeout(int msecs);
+
     /**
      * This method opens the specified scanner device and adds the scan options to the
      * options list.
@@ -142,6 +179,161 @@ public:
      */
     bool closeDevice();
 
+    /**
+     * This function keeps the device open for the given time after closeDevice() has been called.
+     * Opening the same device again within this time reuses the device handle and the options,
+     * which is much faster than opening the device from scratch. The options are reset to the
+     * values they had after the device was opened before.
+     * Opening another device or reloading the devices list closes the kept device.
+     * @param msecs is the time in milliseconds, 0 closes devices immediately, which is the default
+     * @since 25.04
+     */
+    void setDeviceKeepAliveTime(int msecs);
+
+    /**
+     * This function sets the priority of the thread reading the image data from the device.
+     * A higher priority helps devices that stop and reposition the scan head whenever
+     * the data is not read fast enough. On Linux QThread::TimeCriticalPriority uses the
+     * realtime scheduling if the process is allowed to.
+     * @param priority the priority of the thread, QThread::InheritPriority is the default
+     * and restores the normal priority.
+     * @since 25.04
+     */
+    void setScanThreadPriority(QThread::Priority priority);
+
+    /**
+     * This function restricts the thread reading the image data from the device to the given CPUs.
+     * This is only supported on Linux.
+     * @param cpus the indexes of the CPUs, an empty list allows all CPUs, which is the default.
+     * @since 25.04
+     */
+    void setScanThreadAffinity(const QList<int> &cpus);
+
+    /**
+     * This function sets how often the progress of a scan is reported with scanProgress(),
+     * previewProgress() and scanRateUpdated(). The progress is reported when it has grown
+     * by the given step and the given time has passed since the last report.
+     * @param percentStep the minimum step in percent, 0 reports the progress after every
+     * block of data read from the device. The default is 1.
+     * @param minimumInterval the minimum time in milliseconds between two reports,
+     * the default is 100.
+     * @since 25.04
+     */
+    void setScanProgressThresholds(int percentStep, int minimumInterval);
+
+    /**
+     * This function limits the number of scanned pages which have not been delivered yet
+     * with scannedImageReady(). When the limit is reached while scanning with a document feeder,
+     * the next sheet is only fed after the application has processed the pending pages.
+     * This bounds the memory used by a slow application.
+     * @param pages the maximum number of pending pages, 0 disables the limit, which is the default.
+     * @since 25.04
+     */
+    void setMaximumPendingPages(int pages);
+
+    /**
+     * This function sets when a scanned page is considered blank, see imageMetadataReady().
+     * The detection happens while the image is received and does not need an additional pass over the image.
+     * @param maximumInkRatio the maximum share of dark pixels of a blank page, the default is 0.005.
+     * @param marginPercent the width of the borders in percent of the page size which are ignored,
+     * the default is 5.
+     * @since 25.04
+     */
+    void setBlankPageDetection(double maximumInkRatio, int marginPercent);
+
+    /**
+     * This function enables dropping blank pages. A blank page is not delivered with scannedImageReady(),
+     * which saves processing, e.g. for the back sides of duplex scans.
+     * @param skip 'true' to drop blank pages, 'false' is the default.
+     * @since 25.04
+     */
+    void setSkipBlankPages(bool skip);
+
+    /**
+     * This function enables the automatic reduction of the image format. Every page is classified
+     * while it is received as color, gray or lineart page, see imageMetadataReady(). Gray pages
+     * are delivered as grayscale images, lineart pages as monochrome images, which saves memory
+     * and processing when everything is scanned in color.
+     * @param enable 'true' to reduce the image format, 'false' is the default.
+     * @since 25.04
+     */
+    void setAutomaticColorReduction(bool enable);
+
+    /**
+     * This function enables cropping the images to their content. The area of the page which differs
+     * from the white background is determined while the image is received, see imageMetadataReady().
+     * The cropped image shares the image data with the full image.
+     * @param enable 'true' to crop the images, 'false' is the default.
+     * @since 25.04
+     */
+    void setAutomaticCrop(bool enable);
+
+    /**
+     * This function enables adjusting the scan area to the content of the scanned image.
+     * After a scan or preview scan, the top left and bottom right options are set to the area
+     * of the image which differs from the white background, so that the next scan only covers
+     * the document, e.g. a small document on the flatbed.
+     * @param enable 'true' to adjust the scan area, 'false' is the default.
+     * @since 25.04
+     */
+    void setAdjustScanAreaToContent(bool enable);
+
+    /**
+     * This function enables building reduced images, e.g. thumbnails, alongside the scanned image.
+     * The width and height of the reduced images are the ones of the scanned image divided by the factors,
+     * every pixel is the average of the pixels it covers. The reduced images are built while
+     * the image is received, so they are complete when the scan ends, see imageMetadataReady().
+     * Monochrome images are reduced to grayscale images.
+     * @param factors e.g. {4, 16} for images with a quarter and a sixteenth of the width and height,
+     * factors below 2 are ignored. No reduced images are built by default.
+     * @since 25.04
+     */
+    void setReductionFactors(const QList<int> &factors);
+
+    /**
+     * This function enables hashing the pages while they are received, see imageMetadataReady().
+     * The SHA-256 hash of the image data identifies identical images, e.g. for archiving.
+     * The perceptual hash identifies similar pages, e.g. a sheet which has been fed twice.
+     * @param enable 'true' to hash the pages, 'false' is the default.
+     * @since 25.04
+     */
+    void setPageHashing(bool enable);
+
+    /**
+     * This function enables marking pages which are duplicates of one of the previous pages,
+     * e.g. a sheet which was fed twice or scanned again after a paper jam. A page is a duplicate
+     * if its image data is identical or its perceptual hash differs from the one of a previous page
+     * in at most the given number of bits, see imageMetadataReady(). Blank pages are not compared.
+     * The pages are hashed as with setPageHashing().
+     * @param pages is the number of previous pages to compare with, 0 disables the detection which is the default.
+     * @param maximumDistance is the number of bits of the perceptual hashes which may differ, out of 64.
+     * @since 25.04
+     */
+    void setDuplicatePageDetection(int pages, int maximumDistance = 4);
+
+    /**
+     * This function enables reusing the image of the last preview scan for final scans.
+     * A final scan is cropped from the preview image without scanning again if its area
+     * lies within the preview, its resolution and bit depth are not higher and its mode
+     * and all other options which affect the image have the same values as for the preview.
+     * Lower resolutions and bit depths are converted from the preview image. The preview image
+     * is dropped as soon as an option affecting the image is changed.
+     * @note Some backends scan previews in their preview mode with a lower quality,
+     * which is then also the quality of the reused image.
+     * @param enable 'true' to reuse the preview image, 'false' is the default.
+     * @since 25.04
+     */
+    void setReusePreviewScan(bool enable);
+
+    /**
+     * This function enables straightening skewed pages. The skew angle is estimated
+     * from the rows while the image is received, see imageMetadataReady(). The image is rotated
+     * on a separate thread before it is delivered, while the next sheet is already being scanned.
+     * @param enable 'true' to straighten the images, 'false' is the default.
+     * @since 25.04
+     */
+    void setAutomaticDeskew(bool enable);
+
     /**
      * This method returns the internal device name of the currently opened scanner.
      * @note Due to limitations of the SANE API, this will function will return an empty string
@@ -172,6 +364,28 @@ public:
      */
     void setPreviewResolution(float dpi);
 
+    /**
+     * This function enables executing all reads and writes of option values on a worker thread
+     * instead of the calling thread. This keeps the calling thread responsive with slow backends,
+     * e.g. network scanners. Writes return immediately, consecutive writes of the same option
+     * which are still pending are combined and only the last value is written.
+     * The options emit valueChanged() once new values have been read from the device.
+     * Use Option::setValueAsync() to wait for a write to be completed.
+     * @note Scans are started after all pending option accesses have been finished.
+     * @param enable whether the option accesses are done asynchronously, disabled by default
+     * @since 25.04
+     */
+    void setAsynchronousOptionAccess(bool enable);
+
+    /**
+     * This function delays writing gamma tables to the device until their value did not change
+     * for the given time. This avoids writing large tables for every step while e.g. a slider
+     * is moved. Pending tables are always written before a scan is started.
+     * @param msecs the delay in milliseconds, 0 writes the tables right away which is the default
+     * @since 25.04
+     */
+    void setGammaWriteDelay(int msecs);
+
     /**
      * This function returns all available options when a device is opened.
      * @return list containing pointers to all KSaneOptions provided by the backend.
@@ -207,7 +421,9 @@ public:
      * This method can be used to write many parameter values at once.
      * @param options a QMap with the parameter names and values.
      * @return This function returns the number of successful writes
-     * or -1 if scanning is in progress.
+     * or -1 if no device is open or scanning is in progress. This includes
+     * the scans of queued jobs, their options are applied by the queue.
+     * @see queueScanJob
      */
     int setOptionsMap(const QMap<QString, QString> &options);
 
@@ -222,6 +438,39 @@ public:
      */
     QImage *scanImage() const;
 
+    /**
+     * Gives access to the reduced images of the current scan, see setReductionFactors().
+     * The rows which have been received so far are filled in, which is useful to display
+     * a small in-progress image. During a scan, the images must be accessed between
+     * lockScanImage() and unlockScanImage() like scanImage().
+     * @return the reduced images in the order of the factors
+     * @since 25.04
+     */
+    QList<QImage> reducedScanImages() const;
+
+    /**
+     * Gives access to a tile of the image of the current scan while it is received, e.g. to display
+     * parts of a large image. The image is divided into a grid of tiles of 256 x 256 pixels, the
+     * tiles of the last column and row may be smaller. The tile is a view of the scanned image: it
+     * shares the data and does not change anymore, lockScanImage() is not needed.
+     * @note The scanned image is still allocated as a whole, the tiles do not reduce its memory.
+     * @param column is the column of the tile, counted from the left
+     * @param row is the row of the tile, counted from the top
+     * @return the tile or a null image if not all of its rows have been received yet
+     * @see scanTilesReady()
+     * @since 25.04
+     */
+    QImage scanTile(int column, int row) const;
+
+    /**
+     * Gives access to an area of the image of the current scan like scanTile().
+     * @param area is the area in pixels of the scanned image
+     * @return the part of the area within the image, or a null image if not all of its rows
+     * have been received yet
+     * @since 25.04
+     */
+    QImage scanRegion(const QRect &area) const;
+
     /**
      * Locks the mutex protecting the QImage pointer of scanImage() from
      * concurrent access during scanning.
@@ -253,9 +502,80 @@ public:
      */
     QJsonObject scannerOptionsToJson();
 
+    /**
+     * Returns a JSON object with statistics about the current or last scan.
+     * A scanner device must have been opened before, returns an empty object otherwise.
+     * The object holds these values by name:
+     * - "scannedPages": the number of scanned pages
+     * - "blankPages": the number of blank pages among them, if they are detected,
+     *   see setBlankPageDetection()
+     * - "duplicatePages": the number of duplicate pages among them, if they are detected,
+     *   see setDuplicatePageDetection()
+     * - "stallCount": how often the scan was paused because of too many pending pages,
+     *   see setMaximumPendingPages()
+     * - "stallTime": how long the scan was paused in milliseconds
+     * @return JSON object holding the data
+     * @since 25.04
+     */
+    QJsonObject scanStatisticsToJson();
+
+    /**
+     * Adds a scan job to the queue of the currently opened device.
+     * A job consists of the option values to scan with, as returned by getOptionsMap(),
+     * and is started as soon as the device is idle. Jobs are executed back-to-back in the
+     * order of their priority and jobs with the same priority in the order they were queued.
+     * The scanned images of a job are reported as results of its future, see scanJobFuture(),
+     * as well as with the usual signals. Closing the device cancels all queued jobs.
+     * @param options a QMap with the parameter names and values for the job.
+     * @param priority jobs with a higher priority are started first.
+     * @return the id of the job or -1 if no device is open.
+     * @since 25.04
+     */
+    int queueScanJob(const QMap<QString, QString> &options, int priority = 0);
+
+    /**
+     * Returns the future of a scan job. Every scanned page is added as a result,
+     * the progress value from 0 to 100 reports the progress of the current page.
+     * The future is finished when the job is done and canceled when the job
+     * was cancelled before it was started. Cancelling the future cancels the job.
+     * @param jobId the id returned by queueScanJob().
+     * @return the future of the job or an invalid future for an unknown job.
+     * @since 25.04
+     */
+    QFuture<QImage> scanJobFuture(int jobId) const;
+
+    /**
+     * Cancels a scan job. A queued job is removed from the queue, a running job is stopped
+     * like with stopScan().
+     * @param jobId the id returned by queueScanJob().
+     * @return 'true' if the job was queued or running.
+     * @since 25.04
+     */
+    bool cancelScanJob(int jobId);
+
+    /**
+     * Changes the priority of a queued scan job.
+     * @param jobId the id returned by queueScanJob().
+     * @param priority the new priority of the job.
+     * @return 'true' if the job is still queued.
+     * @since 25.04
+     */
+    bool setScanJobPriority(int jobId, int priority);
+
+    /**
+     * Applies the options of the next queued scan job as soon as the last page of the
+     * current job has been read, before the page is reported to the application.
+     * This saves the time the application needs to process the page, but the option
+     * values reported during the processing already belong to the next job.
+     * @param enable 'true' to apply the options early, 'false' is the default.
+     * @since 25.04
+     */
+    void setApplyScanJobOptionsEarly(bool enable);
+
 public Q_SLOTS:
     /**
      * This method is used to cancel a scan or prevent an automatic new scan.
+     * All queued scan jobs are cancelled as well.
      */
     void stopScan();
 
@@ -285,6 +605,20 @@ public Q_SLOTS:
      */
     void startPreviewScan();
 
+    /**
+     * This method is used to scan several areas of the scan area at once, e.g. several photos
+     * on the flatbed. The device scans the area covering all regions in a single pass and every
+     * region is delivered with regionImageReady() as soon as its last row has been received.
+     * The images of the regions share the data of the scanned image, instead of scannedImageReady()
+     * only the regions are delivered. The top left and bottom right options are restored
+     * when the scan has finished.
+     * @param regions are the areas to scan in the unit of the top left and bottom right options.
+     * @return 'true' if the scan was started, 'false' if the device does not support scan areas
+     * or a scan is already running.
+     * @since 25.04
+     */
+    bool startRegionScan(const QList<QRectF> &regions);
+
 Q_SIGNALS:
     /**
      * This signal is emitted when a final scan is ready.
@@ -300,6 +634,23 @@ Q_SIGNALS:
      */
     void previewImageReady(const QImage &previewImage);
 
+    /**
+     * This signal is emitted for every region of a scan started with startRegionScan().
+     * @param region is the index of the region in the list given to startRegionScan().
+     * @param image contains the image data of the region, it is null if the region
+     * is outside of the scanned area.
+     * @since 25.04
+     */
+    void regionImageReady(int region, const QImage &image);
+
+    /**
+     * This signal is emitted when all tiles of a row of tiles have been received, see scanTile().
+     * @param row is the row of the tiles which are ready
+     * @param columns is the number of tiles in a row
+     * @since 25.04
+     */
+    void scanTilesReady(int row, int columns);
+
     /**
      * This signal is emitted when the scanning has ended.
      * @param status contains a ScanStatus status code.
@@ -325,6 +676,43 @@ Q_SIGNALS:
      */
     void userMessage(KSaneCore::Interface::ScanStatus status, const QString &strStatus);
 
+    /**
+     * This signal is emitted right before scannedImageReady() or previewImageReady() with
+     * information gathered about the image while it was received.
+     * @param metadata holds these values by name:
+     * - "blankPage" (bool): whether the page is blank, see setBlankPageDetection()
+     * - "inkRatio" (double): the share of dark pixels
+     * - "histograms" (QList<QList<qint64>>): a histogram for each color channel or only one
+     *   for gray images, with 256 bins for 8-bit and 65536 bins for 16-bit images
+     * - "minimum", "maximum" (QList<int>) and "mean" (QList<double>): the statistics of
+     *   each channel
+     * - "pageType" (QString): "color", "gray" or "lineart", depending on the content of
+     *   the page
+     * - "contentArea" (QRect): the area of the full image in pixels which differs from the
+     *   white background
+     * - "skewAngle" (double): the angle in degrees the text lines of the page are rotated
+     *   clockwise, estimated in steps of 0.25 degrees up to 5 degrees, if enabled with
+     *   setAutomaticDeskew()
+     * - "sha256" (QString): the hexadecimal SHA-256 hash of the image data, if enabled with
+     *   setPageHashing()
+     * - "perceptualHash" (quint64): a hash of the brightness distribution, if enabled with
+     *   setPageHashing()
+     * - "duplicatePage" (int): the number of pages before this one the page has already been
+     *   scanned, 0 if it has not, if enabled with setDuplicatePageDetection()
+     * - "exactDuplicate" (bool): whether the image data is identical to the earlier page, if
+     *   enabled with setDuplicatePageDetection()
+     * - "reducedImages" (QList<QImage>): the reduced images of the scanned image, if enabled
+     *   with setReductionFactors()
+     *
+     * The hashes and the reduced images are computed before the image is cropped,
+     * straightened or converted.
+     * @note The analyses of a page are only done if this signal is connected when the scan
+     * is started or their results are needed for an enabled feature, e.g. the blank page
+     * detection with setSkipBlankPages().
+     * @since 25.04
+     */
+    void imageMetadataReady(const QVariantMap &metadata);
+
     /**
      * This signal is emitted for progress information during a scan.
      * @param percent is the percentage of the scan progress (0-100).
@@ -340,6 +728,15 @@ Q_SIGNALS:
      */
     void previewProgress(int percent);
 
+    /**
+     * This signal is emitted together with the progress information of a scan or preview scan.
+     * @param bytesPerSecond is the rate the image data is received with.
+     * @param remainingTime is the estimated time in milliseconds until the image is complete,
+     * -1 if it can not be estimated.
+     * @since 25.04
+     */
+    void scanRateUpdated(qint64 bytesPerSecond, int remainingTime);
+
     /**
      * This signal is emitted every time the device list is updated or
      * after reloadDevicesList() is called.
@@ -350,6 +747,15 @@ Q_SIGNALS:
      */
     void availableDevices(const QList<DeviceInformation *> &deviceList);
 
+    /**
+     * This signal is emitted when a refresh of the device list found added or removed devices.
+     * availableDevices() is emitted with the complete list before.
+     * @param addedDevices are the devices which have been found in addition to the last known ones.
+     * @param removedDeviceNames are the names of the devices which are not available anymore.
+     * @since 25.04
+     */
+    void devicesListChanged(const QList<DeviceInformation *> &addedDevices, const QStringList &removedDeviceNames);
+
     /**
      * This signal is emitted when a hardware button is pressed.
      * @param optionName is the untranslated technical name of the sane-option.
@@ -10,7 +10,10 @@
 #include "interface_p.h"
 
 #include <QImage>
-#include <QRegularExpression>
+#include <QMetaMethod>
+#include <QThreadPool>
+
+#include <algorithm>
 
 #include <ksanecore_debug.h>
 
@@ -20,11 +23,14 @@
 #include "booloption.h"
 #include "doubleoption.h"
 #include "gammaoption.h"
+#include "imageprocessor.h"
 #include "integeroption.h"
 #include "internaloption.h"
 #include "invertoption.h"
 #include "listoption.h"
+#include "pageanalyzer.h"
 #include "pagesizeoption.h"
+#include "softwaregammaoption.h"
 #include "stringoption.h"
 
 namespace KSaneCore
@@ -38,11 +44,13 @@ InterfacePrivate::InterfacePrivate(Interface *parent)
     m_findDevThread = FindSaneDevicesThread::getInstance();
     connect(m_findDevThread, &FindSaneDevicesThread::finished, this, &InterfacePrivate::devicesListUpdated);
     connect(m_findDevThread, &FindSaneDevicesThread::finished, this, &InterfacePrivate::signalDevicesListUpdate);
+    connect(m_findDevThread, &FindSaneDevicesThread::localDevicesFound, this, &InterfacePrivate::signalLocalDevices);
+    m_discoveryTimer.setSingleShot(true);
+    connect(&m_discoveryTimer, &QTimer::timeout, this, &InterfacePrivate::discoveryTimedOut);
+    m_keepAliveTimer.setSingleShot(true);
+    connect(&m_keepAliveTimer, &QTimer::timeout, this, &InterfacePrivate::releaseParkedDevice);
 
     m_auth = Authentication::getInstance();
-    m_optionPollTimer.setInterval(100);
-    connect(&m_optionPollTimer, &QTimer::timeout, this, &InterfacePrivate::pollPollOptions);
-
     m_batchModeTimer.setInterval(1000);
     connect(&m_batchModeTimer, &QTimer::timeout, this, &InterfacePrivate::batchModeTimerUpdate);
 }
@@ -105,6 +113,10 @@ Interface::OpenStatus InterfacePrivate::loadDeviceOptions()
     }
     numSaneOptions = *reinterpret_cast<SANE_Word *>(data.data());
 
+    // all further option accesses are serialized by the option worker
+    m_optionWorker = new OptionWorker(m_saneHandle);
+    connectOptionWorker();
+
     // read the rest of the options
     BaseOption *option = nullptr;
     BaseOption *optionTopLeftX = nullptr;
@@ -117,7 +129,7 @@ Interface::OpenStatus InterfacePrivate::loadDeviceOptions()
     m_optionsList.reserve(numSaneOptions);
     m_externalOptionsList.reserve(numSaneOptions);
     for (int i = 1; i < numSaneOptions; ++i) {
-        switch (BaseOption::optionType(sane_get_option_descriptor(m_saneHandle, i))) {
+        switch (BaseOption::optionType(m_optionWorker->optionDescriptor(i))) {
         case Option::TypeDetectFail:
             option = new BaseOption(m_saneHandle, i);
             break;
@@ -136,13 +148,17 @@ Interface::OpenStatus InterfacePrivate::loadDeviceOptions()
         case Option::TypeString:
             option = new StringOption(m_saneHandle, i);
             break;
-        case Option::TypeGamma:
-            option = new GammaOption(m_saneHandle, i);
+        case Option::TypeGamma: {
+            GammaOption *gammaOption = new GammaOption(m_saneHandle, i);
+            gammaOption->setWriteDelay(m_gammaWriteDelay);
+            option = gammaOption;
             break;
+        }
         case Option::TypeAction:
             option = new ActionOption(m_saneHandle, i);
             break;
         }
+        option->setOptionWorker(m_optionWorker);
         option->readOption();
         option->readValue();
 
@@ -179,10 +195,14 @@ Interface::OpenStatus InterfacePrivate::loadDeviceOptions()
         m_optionsList.append(option);
         m_externalOptionsList.append(new InternalOption(option));
         connect(option, &BaseOption::optionsNeedReload, this, &InterfacePrivate::reloadOptions);
-        connect(option, &BaseOption::valuesNeedReload, this, &InterfacePrivate::scheduleValuesReload);
+        connect(option, &BaseOption::valuesNeedReload, this, [=]() {
+            m_valuesReloadTrigger = option;
+            scheduleValuesReload();
+        });
 
         if (option->needsPolling()) {
             m_optionsPollList.append(option);
+            m_optionWorker->addPollOption(option->index(), option->valueDataSize());
             if (option->type() == Option::TypeBool) {
                 connect(option, &BaseOption::valueChanged, this, [=](const QVariant &newValue) {
                     Q_EMIT q->buttonPressed(option->name(), option->title(), newValue.toBool());
@@ -220,26 +240,36 @@ Interface::OpenStatus InterfacePrivate::loadDeviceOptions()
     m_externalOptionsList.append(new InternalOption(invertOption));
     m_optionsLocation.insert(Interface::InvertColorOption, m_optionsList.size() - 1);
 
-    // NOTICE The Pixma network backend behaves badly. polling a value will result in 1 second
-    // sleeps for every poll. The problem has been reported, but no easy/quick fix was available and
-    // the bug has been there for multiple years. Since this destroys the usability of the backend totally,
-    // we simply put the backend on the naughty list and disable the option polling.
-    static QRegularExpression pixmaNetworkBackend(QStringLiteral("pixma.*\\d+\\.\\d+\\.\\d+\\.\\d+"));
-    m_optionPollingNaughtylisted = false;
-    if (pixmaNetworkBackend.match(m_devName).hasMatch()) {
-        m_optionPollingNaughtylisted = true;
-    }
+    // add extra option for applying brightness, contrast and gamma while receiving the image
+    BaseOption *softwareGammaOption = new SoftwareGammaOption();
+    m_optionsList.append(softwareGammaOption);
+    m_externalOptionsList.append(new InternalOption(softwareGammaOption));
+    m_optionsLocation.insert(Interface::SoftwareGammaOption, m_optionsList.size() - 1);
 
-    // start polling the poll options
-    if (m_optionsPollList.size() > 0 && !m_optionPollingNaughtylisted) {
-        m_optionPollTimer.start();
-    }
+    // start polling the poll options, the worker adapts the poll rate to the backend
+    enableOptionPolling();
 
     // Create the scan thread
     m_scanThread = new ScanThread(m_saneHandle);
+    if (m_scanThreadPriority != QThread::InheritPriority) {
+        m_scanThread->setReaderPriority(m_scanThreadPriority);
+    }
+    if (!m_scanThreadAffinity.isEmpty()) {
+        m_scanThread->setReaderAffinity(m_scanThreadAffinity);
+    }
+    m_scanThread->setProgressThresholds(m_progressStep, m_progressInterval);
+    m_scanThread->setMaximumPendingPages(m_maxPendingPages);
+    m_scanThread->setBlankPageDetection(m_blankPageInkRatio, m_blankPageMargin);
+    m_scanThread->setSkipBlankPages(m_skipBlankPages);
+    m_scanThread->setAutomaticColorReduction(m_reduceColors);
+    m_scanThread->setAutomaticCrop(m_cropToContent);
+    m_scanThread->setAutomaticDeskew(m_deskew);
+    m_scanThread->setReductionFactors(m_reductionFactors);
 
     m_scanThread->setImageInverted(invertOption->value());
     connect(invertOption, &InvertOption::valueChanged, m_scanThread, &ScanThread::setImageInverted);
+    m_scanThread->setImageGamma(softwareGammaOption->value());
+    connect(softwareGammaOption, &BaseOption::valueChanged, m_scanThread, &ScanThread::setImageGamma);
 
     if (optionResolution != nullptr) {
         m_scanThread->setImageResolution(optionResolution->value());
@@ -247,10 +277,18 @@ Interface::OpenStatus InterfacePrivate::loadDeviceOptions()
     }
 
     connect(m_scanThread, &ScanThread::scanProgressUpdated, this, &InterfacePrivate::emitProgress);
-    connect(m_scanThread, &ScanThread::finished, this, &InterfacePrivate::imageScanFinished);
+    connect(m_scanThread, &ScanThread::scanRateUpdated, q, &Interface::scanRateUpdated);
+    connect(m_scanThread, &ScanThread::scanFinished, this, &InterfacePrivate::imageScanFinished);
+    connect(m_scanThread, &ScanThread::pageScanned, this, &InterfacePrivate::pageScanned);
+    connect(m_scanThread, &ScanThread::regionScanned, q, &Interface::regionImageReady);
+    connect(m_scanThread, &ScanThread::tilesCompleted, q, &Interface::scanTilesReady);
+
+    // the initial values have been read, from now on the option worker executes the accesses if requested
+    m_optionWorker->setAsynchronous(m_asynchronousOptionAccess);
 
     // try to set to default values
     setDefaultValues();
+    m_initialOptionValues = q->getOptionsMap();
     return Interface::OpeningSucceeded;
 }
 
@@ -264,7 +302,14 @@ void InterfacePrivate::clearDeviceOptions()
 
     m_optionsLocation.clear();
     m_optionsPollList.clear();
-    m_optionPollTimer.stop();
+    m_previewCache = PreviewCache();
+    m_readValuesTimer.stop();
+    m_valuesReloadTrigger = nullptr;
+    m_scanWaitingForOptionWorker = false;
+
+    // waits for a running read to finish
+    delete m_optionWorker;
+    m_optionWorker = nullptr;
 
     m_devName.clear();
     m_model.clear();
@@ -273,6 +318,124 @@ void InterfacePrivate::clearDeviceOptions()
     m_batchModeDelay = nullptr;
 }
 
+void InterfacePrivate::releaseDevice()
+{
+    disconnect(m_scanThread);
+    // do not wait for a cancelled scan, the thread is deleted when it has finished
+    connect(m_scanThread, &QThread::finished, m_scanThread, &QThread::deleteLater);
+    m_scanThread->shutdown();
+    if (m_scanThread->isFinished()) {
+        m_scanThread->deleteLater();
+    }
+    m_scanThread = nullptr;
+
+    m_auth->clearDeviceAuth(m_devName);
+    // the option worker must be finished before the handle becomes invalid
+    clearDeviceOptions();
+    sane_close(m_saneHandle);
+    m_saneHandle = nullptr;
+}
+
+bool InterfacePrivate::parkDevice()
+{
+    // only one device is kept and a cancelled scan might still be running
+    releaseParkedDevice();
+    if (m_keepAliveTime <= 0 || m_scanThread->isScanning()) {
+        return false;
+    }
+
+    m_optionWorker->setPollingEnabled(false);
+    // the options of the parked device must not receive values meanwhile
+    disconnect(m_optionWorker, nullptr, this, nullptr);
+    m_readValuesTimer.stop();
+    m_batchModeTimer.stop();
+    m_valuesReloadTrigger = nullptr;
+    m_scanWaitingForOptionWorker = false;
+
+    swapParkedDevice();
+    m_keepAliveTimer.start(m_keepAliveTime);
+    qCDebug(KSANECORE_LOG) << "Keeping device" << m_parkedDevice.devName << "open for" << m_keepAliveTime << "ms";
+    return true;
+}
+
+bool InterfacePrivate::reopenParkedDevice(const QString &deviceName)
+{
+    if (m_parkedDevice.saneHandle == nullptr) {
+        return false;
+    }
+    if (m_parkedDevice.devName != deviceName) {
+        releaseParkedDevice();
+        return false;
+    }
+    m_keepAliveTimer.stop();
+    swapParkedDevice();
+    connectOptionWorker();
+
+    // check that the handle is still usable and describes the same options
+    SANE_Word numSaneOptions = 0;
+    const SANE_Status status = m_optionWorker->controlOption(0, SANE_ACTION_GET_VALUE, &numSaneOptions, nullptr);
+    const int numDeviceOptions = std::count_if(m_optionsList.cbegin(), m_optionsList.cend(), [](const BaseOption *option) {
+        return option->index() > 0;
+    });
+    if (status != SANE_STATUS_GOOD || numSaneOptions - 1 != numDeviceOptions) {
+        qCDebug(KSANECORE_LOG) << "Parked device" << deviceName << "can not be reused, opening it again";
+        releaseDevice();
+        return false;
+    }
+
+    // behave like a freshly opened device
+    const QMap<QString, QString> currentValues = q->getOptionsMap();
+    QMap<QString, QString> changedValues;
+    for (auto it = m_initialOptionValues.cbegin(); it != m_initialOptionValues.cend(); ++it) {
+        if (currentValues.value(it.key()) != it.value()) {
+            changedValues.insert(it.key(), it.value());
+        }
+    }
+    q->setOptionsMap(changedValues);
+    enableOptionPolling();
+    return true;
+}
+
+void InterfacePrivate::releaseParkedDevice()
+{
+    if (m_parkedDevice.saneHandle == nullptr) {
+        return;
+    }
+    m_keepAliveTimer.stop();
+    qCDebug(KSANECORE_LOG) << "Closing kept device" << m_parkedDevice.devName;
+    // the current device is parked in the meantime
+    swapParkedDevice();
+    releaseDevice();
+    swapParkedDevice();
+}
+
+void InterfacePrivate::enableOptionPolling()
+{
+    // slow backends, e.g. Pixma network scanners which sleep for every read, are polled less often by the worker
+    m_optionWorker->setPollingEnabled(!m_optionsPollList.isEmpty());
+}
+
+void InterfacePrivate::swapParkedDevice()
+{
+    std::swap(m_saneHandle, m_parkedDevice.saneHandle);
+    std::swap(m_devName, m_parkedDevice.devName);
+    std::swap(m_vendor, m_parkedDevice.vendor);
+    std::swap(m_model, m_parkedDevice.model);
+    std::swap(m_optionsList, m_parkedDevice.optionsList);
+    std::swap(m_externalOptionsList, m_parkedDevice.externalOptionsList);
+    std::swap(m_optionsLocation, m_parkedDevice.optionsLocation);
+    std::swap(m_optionsPollList, m_parkedDevice.optionsPollList);
+    std::swap(m_initialOptionValues, m_parkedDevice.initialOptionValues);
+    std::swap(m_scanThread, m_parkedDevice.scanThread);
+    std::swap(m_optionWorker, m_parkedDevice.optionWorker);
+    std::swap(m_batchMode, m_parkedDevice.batchMode);
+    std::swap(m_batchModeDelay, m_parkedDevice.batchModeDelay);
+    std::swap(m_executeMultiPageScanning, m_parkedDevice.executeMultiPageScanning);
+    std::swap(m_waitForExternalButton, m_parkedDevice.waitForExternalButton);
+    // the preview belongs to the other device
+    m_previewCache = PreviewCache();
+}
+
 void InterfacePrivate::devicesListUpdated()
 {
     if (m_vendor.isEmpty()) {
@@ -289,6 +452,39 @@ void InterfacePrivate::devicesListUpdated()
 
 void InterfacePrivate::signalDevicesListUpdate()
 {
+    if (m_findDevThread->devicesListChanged()) {
+        Q_EMIT q->availableDevices(m_findDevThread->devicesList());
+        Q_EMIT q->devicesListChanged(m_findDevThread->addedDevices(), m_findDevThread->removedDevices());
+    } else if (m_devicesListRequested) {
+        Q_EMIT q->availableDevices(m_findDevThread->devicesList());
+    }
+    m_devicesListRequested = false;
+    m_discoveryTimer.stop();
+}
+
+void InterfacePrivate::signalLocalDevices(const QList<DeviceInformation *> &addedDevices)
+{
+    if (!addedDevices.isEmpty()) {
+        Q_EMIT q->availableDevices(m_findDevThread->devicesList());
+        Q_EMIT q->devicesListChanged(addedDevices, QStringList());
+    } else if (m_devicesListRequested) {
+        Q_EMIT q->availableDevices(m_findDevThread->devicesList());
+    }
+    m_devicesListRequested = false;
+}
+
+void InterfacePrivate::discoveryTimedOut()
+{
+    // report what is known so far, the slow backends are reported once they answered
+    if (m_devicesListRequested) {
+        m_devicesListRequested = false;
+        Q_EMIT q->availableDevices(m_findDevThread->devicesList());
+    }
+}
+
+void InterfacePrivate::signalCachedDevicesList()
+{
+    devicesListUpdated();
     Q_EMIT q->availableDevices(m_findDevThread->devicesList());
 }
 
@@ -319,6 +515,7 @@ void InterfacePrivate::scheduleValuesReload()
 
 void InterfacePrivate::reloadOptions()
 {
+    m_previewCache = PreviewCache();
     Q_EMIT optionsAboutToBeReloaded();
     for (const auto option : std::as_const(m_optionsList)) {
         option->readOption();
@@ -331,39 +528,150 @@ void InterfacePrivate::reloadOptions()
 void InterfacePrivate::reloadValues()
 {
     for (const auto option : std::as_const(m_optionsList)) {
+        // the value of the option which triggered the reload has just been written and
+        // options which are hidden or have only one possible value can not have changed
+        if (option == m_valuesReloadTrigger || !option->hasReadableValue() || option->hasConstantValue()) {
+            continue;
+        }
         option->readValue();
     }
+    m_valuesReloadTrigger = nullptr;
 }
 
-void InterfacePrivate::emitProgress(int progress)
+BaseOption *InterfacePrivate::deviceOption(int index) const
 {
-    if (m_previewScan) {
-        Q_EMIT q->previewProgress(progress);
+    if (index < 1 || index > m_optionsList.size()) {
+        return nullptr;
+    }
+    BaseOption *option = m_optionsList.at(index - 1);
+    if (option->index() != index) {
+        return nullptr;
+    }
+    return option;
+}
+
+BaseOption *InterfacePrivate::workerOption(int index) const
+{
+    // queued replies of the worker of a parked device can still arrive
+    if (sender() != m_optionWorker) {
+        return nullptr;
+    }
+    return deviceOption(index);
+}
+
+void InterfacePrivate::connectOptionWorker()
+{
+    connect(m_optionWorker, &OptionWorker::valueRead, this, &InterfacePrivate::applyValueData);
+    connect(m_optionWorker, &OptionWorker::valueStored, this, &InterfacePrivate::storeValueData);
+    connect(m_optionWorker, &OptionWorker::valueWritten, this, &InterfacePrivate::valueWritten);
+    connect(m_optionWorker, &OptionWorker::polledValueChanged, this, &InterfacePrivate::applyPolledValue);
+    connect(m_optionWorker, &OptionWorker::idle, this, &InterfacePrivate::optionWorkerIdle);
+}
+
+void InterfacePrivate::applyValueData(int index, const QByteArray &data, int serial)
+{
+    BaseOption *option = workerOption(index);
+    // discard the value if the option has been written after the read was queued
+    if (option != nullptr && option->writeCount() == serial) {
+        option->applyValueData(data);
+    }
+}
+
+void InterfacePrivate::storeValueData(int index, const QByteArray &data)
+{
+    BaseOption *option = workerOption(index);
+    if (option != nullptr) {
+        option->storeValueData(data);
+    }
+}
+
+void InterfacePrivate::applyPolledValue(int index, const QByteArray &data)
+{
+    BaseOption *option = workerOption(index);
+    if (option != nullptr) {
+        option->applyValueData(data);
+    }
+}
+
+void InterfacePrivate::valueWritten(int index, int status, int info)
+{
+    BaseOption *option = workerOption(index);
+    if (option != nullptr) {
+        option->writeFinished(static_cast<SANE_Status>(status), info);
+    }
+}
+
+void InterfacePrivate::startScanThread()
+{
+    m_scanThread->setPageAnalyses(pageAnalyses());
+    // the scan thread continues with the next sheet of the document feeder on its own
+    m_scanThread->setMultiPageScanning(m_executeMultiPageScanning && !m_previewScan && !m_regionScan);
+    if (m_optionWorker->isIdle()) {
+        m_scanThread->startScan();
     } else {
-        Q_EMIT q->scanProgress(progress);
+        m_scanWaitingForOptionWorker = true;
     }
 }
 
-void InterfacePrivate::pollPollOptions()
+void InterfacePrivate::writePendingGammaTables()
 {
-    for (int i = 1; i < m_optionsPollList.size(); ++i) {
-        m_optionsPollList.at(i)->readValue();
+    for (BaseOption *option : std::as_const(m_optionsList)) {
+        // the software gamma option has the gamma type as well, but nothing to write
+        if (GammaOption *gammaOption = qobject_cast<GammaOption *>(option)) {
+            gammaOption->writePendingData();
+        }
+    }
+}
+
+void InterfacePrivate::optionWorkerIdle()
+{
+    // the worker might have received new requests since it emitted the signal
+    if (m_scanWaitingForOptionWorker && m_optionWorker->isIdle()) {
+        m_scanWaitingForOptionWorker = false;
+        m_scanThread->startScan();
+    }
+}
+
+void InterfacePrivate::emitProgress(int progress)
+{
+    if (m_currentScanJob.promise && progress >= 0) {
+        // the progress of a job grows by 100 for each page
+        const auto &promise = m_currentScanJob.promise;
+        promise->setProgressRange(0, (m_currentScanJob.pages + 1) * 100);
+        promise->setProgressValue(m_currentScanJob.pages * 100 + progress);
+        if (promise->isCanceled() && m_scanThread->isScanning()) {
+            // the job was cancelled through its future
+            m_cancelMultiPageScan = true;
+            m_scanThread->cancelScan();
+        }
+    }
+    if (m_previewScan) {
+        Q_EMIT q->previewProgress(progress);
+    } else {
+        Q_EMIT q->scanProgress(progress);
     }
 }
 
 void InterfacePrivate::imageScanFinished()
 {
+    // nothing could start a new scan before the finished one is handled
+    m_scanThread->scanFinishHandled();
     emitProgress(100);
     if (m_scanThread->frameStatus() == ScanThread::ReadReady) {
         if (m_previewScan) {
+            storePreviewCache(*m_scanThread->scanImage());
+            storeContentScanArea(*m_scanThread->scanImage(), m_scanThread->pageMetadata());
+            Q_EMIT q->imageMetadataReady(m_scanThread->pageMetadata());
             Q_EMIT q->previewImageReady(*m_scanThread->scanImage());
+        } else if (m_regionScan) {
+            // the regions have already been delivered by regionScanned()
         } else {
-            Q_EMIT q->scannedImageReady(*m_scanThread->scanImage());
-            // now check if we should have automatic ADF batch scanning
-            if (m_executeMultiPageScanning && !m_cancelMultiPageScan) {
-                emitProgress(-1);
-                m_scanThread->start();
-                return;
+            // sheets of the document feeder are delivered by pageScanned(), this is the last one
+            const bool morePages = (m_batchMode->value().toBool() && !m_cancelMultiPageScan) || m_waitForExternalButton;
+            if (!m_scanThread->skipPage()) {
+                deliverScannedImage(*m_scanThread->scanImage(), m_scanThread->pageMetadata(), !morePages);
+            } else if (!morePages && m_currentScanJob.promise) {
+                applyNextScanJobOptions();
             }
             // check if we should have timed batch scanning
             if (m_batchMode->value().toBool() && !m_cancelMultiPageScan) {
@@ -377,7 +685,7 @@ void InterfacePrivate::imageScanFinished()
             if (m_waitForExternalButton) {
                 qCDebug(KSANECORE_LOG) << "waiting for external button press to start next scan";
                 emitProgress(-1);
-                m_scanThread->start();
+                m_scanThread->startScan();
                 return;
             }
         }
@@ -408,12 +716,104 @@ void InterfacePrivate::imageScanFinished()
     }
 }
 
-void InterfacePrivate::scanIsFinished(Interface::ScanStatus status, const QString &message)
+void InterfacePrivate::pageScanned(const QImage &image, const QVariantMap &metadata)
+{
+    emitProgress(100);
+    deliverScannedImage(image, metadata, false);
+    m_scanThread->pageDelivered();
+    emitProgress(-1);
+}
+
+void InterfacePrivate::deliverScannedImage(const QImage &image, const QVariantMap &metadata, bool lastPage)
+{
+    if (m_currentScanJob.promise) {
+        if (m_currentScanJob.promise->isCanceled()) {
+            // the job was cancelled through its future
+            stopScanning();
+        }
+        m_currentScanJob.promise->addResult(image);
+        m_currentScanJob.pages++;
+        if (lastPage) {
+            applyNextScanJobOptions();
+        }
+    }
+    storeContentScanArea(image, metadata);
+    QVariantMap pageMetadata = metadata;
+    if (m_duplicatePageDetector.markPage(pageMetadata) > 0) {
+        m_duplicatePageCount++;
+    }
+    Q_EMIT q->imageMetadataReady(pageMetadata);
+    Q_EMIT q->scannedImageReady(image);
+}
+
+bool InterfacePrivate::pageHashingEnabled() const
+{
+    return m_pageHashing || m_duplicatePageDetector.isEnabled();
+}
+
+PageAnalyzer::Analyses InterfacePrivate::pageAnalyses() const
+{
+    // the skew is only estimated for deskewing
+    PageAnalyzer::Analyses analyses = m_deskew ? PageAnalyzer::SkewAnalysis : PageAnalyzer::NoAnalysis;
+    // everything is part of the metadata, otherwise only the enabled features need their analysis
+    if (q->isSignalConnected(QMetaMethod::fromSignal(&Interface::imageMetadataReady))) {
+        return analyses | PageAnalyzer::AllAnalyses;
+    }
+    if (m_skipBlankPages || m_duplicatePageDetector.isEnabled()) {
+        // blank pages are not compared for duplicates
+        analyses |= PageAnalyzer::BlankPageAnalysis;
+    }
+    if (m_reduceColors) {
+        analyses |= PageAnalyzer::PageTypeAnalysis;
+    }
+    if (m_cropToContent || m_adjustScanArea) {
+        analyses |= PageAnalyzer::ContentAnalysis;
+    }
+    return analyses;
+}
+
+void InterfacePrivate::storeContentScanArea(const QImage &image, const QVariantMap &metadata)
+{
+    m_contentScanArea = QRectF();
+    const QRect area = metadata.value(QStringLiteral("contentArea")).toRect();
+    Option *topLeftXOption = q->getOption(Interface::TopLeftXOption);
+    Option *topLeftYOption = q->getOption(Interface::TopLeftYOption);
+    if (!m_adjustScanArea || !area.isValid() || topLeftXOption == nullptr || topLeftYOption == nullptr
+        || topLeftXOption->valueUnit() != Option::UnitMilliMeter || image.dotsPerMeterX() <= 0 || image.dotsPerMeterY() <= 0) {
+        return;
+    }
+
+    // the area is relative to the scanned area
+    const double pixelsPerMillimeterX = image.dotsPerMeterX() / 1000.0;
+    const double pixelsPerMillimeterY = image.dotsPerMeterY() / 1000.0;
+    const double left = topLeftXOption->value().toDouble();
+    const double top = topLeftYOption->value().toDouble();
+    m_contentScanArea = QRectF(QPointF(left + area.left() / pixelsPerMillimeterX, top + area.top() / pixelsPerMillimeterY),
+                               QPointF(left + (area.right() + 1) / pixelsPerMillimeterX, top + (area.bottom() + 1) / pixelsPerMillimeterY));
+}
+
+void InterfacePrivate::applyContentScanArea()
 {
-    sane_cancel(m_saneHandle);
-    if (m_optionsPollList.size() > 0 && !m_optionPollingNaughtylisted) {
-        m_optionPollTimer.start();
+    if (!m_contentScanArea.isValid()) {
+        return;
     }
+    Option *topLeftXOption = q->getOption(Interface::TopLeftXOption);
+    Option *topLeftYOption = q->getOption(Interface::TopLeftYOption);
+    Option *bottomRightXOption = q->getOption(Interface::BottomRightXOption);
+    Option *bottomRightYOption = q->getOption(Interface::BottomRightYOption);
+    if (topLeftXOption != nullptr && topLeftYOption != nullptr && bottomRightXOption != nullptr && bottomRightYOption != nullptr) {
+        topLeftXOption->setValue(m_contentScanArea.left());
+        topLeftYOption->setValue(m_contentScanArea.top());
+        bottomRightXOption->setValue(m_contentScanArea.right());
+        bottomRightYOption->setValue(m_contentScanArea.bottom());
+    }
+    m_contentScanArea = QRectF();
+}
+
+void InterfacePrivate::scanIsFinished(Interface::ScanStatus status, const QString &message)
+{
+    cancelUnfinishedScan();
+    enableOptionPolling();
     if (m_previewScan) {
         // reset to user values for final scan
         Option *topLeftXOption = q->getOption(Interface::TopLeftXOption);
@@ -456,8 +856,31 @@ void InterfacePrivate::scanIsFinished(Interface::ScanStatus status, const QStrin
         m_previewScan = false;
         Q_EMIT q->previewScanFinished(status, message);
     } else {
+        if (m_regionScan) {
+            // reset to the user values of the scan area
+            const QList<Interface::OptionName> areaOptions = {Interface::TopLeftXOption,
+                                                               Interface::TopLeftYOption,
+                                                               Interface::BottomRightXOption,
+                                                               Interface::BottomRightYOption};
+            for (const Interface::OptionName name : areaOptions) {
+                Option *option = q->getOption(name);
+                if (option != nullptr) {
+                    option->restoreSavedData();
+                }
+            }
+            m_scanThread->setScanRegions({});
+            m_regionScan = false;
+        } else if (m_currentScanJob.promise) {
+            // a run of the document feeder ends without a last page
+            applyNextScanJobOptions();
+        }
+        finishScanJob();
         Q_EMIT q->scanFinished(status, message);
     }
+    // after the preview options have been restored
+    applyContentScanArea();
+    // run the queued jobs back-to-back
+    startNextScanJob();
 }
 
 void InterfacePrivate::determineMultiPageScanning(const QVariant &value)
@@ -482,13 +905,258 @@ void InterfacePrivate::batchModeTimerUpdate()
         m_batchModeCounter = 0;
         if (m_scanThread != nullptr) {
             Q_EMIT q->scanProgress(-1);
-            m_scanThread->start();
+            m_scanThread->startScan();
         }
         m_batchModeTimer.stop();
     }
     m_batchModeCounter++;
 }
 
+bool InterfacePrivate::isScanning() const
+{
+    return m_currentScanJob.id != 0 || m_previewScan || m_scanWaitingForOptionWorker || m_servingPreviewCache || m_batchModeTimer.isActive()
+        || (m_scanThread != nullptr && m_scanThread->isScanning());
+}
+
+void InterfacePrivate::stopScanning()
+{
+    m_cancelMultiPageScan = true;
+    if (m_scanWaitingForOptionWorker) {
+        m_scanWaitingForOptionWorker = false;
+        scanIsFinished(Interface::NoError, i18n("Scanning stopped by user."));
+    } else if (m_servingPreviewCache) {
+        m_servingPreviewCache = false;
+        scanIsFinished(Interface::NoError, i18n("Scanning stopped by user."));
+    } else if (m_scanThread->isScanning()) {
+        m_scanThread->cancelScan();
+    } else if (m_batchModeTimer.isActive()) {
+        m_batchModeTimer.stop();
+        Q_EMIT q->batchModeCountDown(0);
+        scanIsFinished(Interface::NoError, i18n("Scanning stopped by user."));
+    }
+}
+
+void InterfacePrivate::enqueueScanJob(ScanJob &&job)
+{
+    // behind all jobs with the same or a higher priority
+    auto it = std::find_if(m_scanJobs.begin(), m_scanJobs.end(), [&job](const ScanJob &queuedJob) {
+        return queuedJob.priority < job.priority;
+    });
+    m_scanJobs.insert(it, std::move(job));
+}
+
+void InterfacePrivate::startNextScanJob()
+{
+    if (m_saneHandle == nullptr || isScanning()) {
+        return;
+    }
+    while (!m_scanJobs.isEmpty()) {
+        ScanJob job = m_scanJobs.takeFirst();
+        if (job.promise->isCanceled()) {
+            // cancelled through its future while it was queued
+            continue;
+        }
+        if (job.id != m_scanJobOptionsApplied) {
+            q->setOptionsMap(job.options);
+        }
+        m_scanJobOptionsApplied = 0;
+        job.promise->start();
+        m_currentScanJob = std::move(job);
+        q->startScan();
+        return;
+    }
+}
+
+void InterfacePrivate::applyNextScanJobOptions()
+{
+    if (!m_applyScanJobOptionsEarly || m_scanJobs.isEmpty() || m_scanJobs.first().promise->isCanceled()
+        || m_scanJobOptionsApplied == m_scanJobs.first().id) {
+        return;
+    }
+    // the device has to leave the scanning state before options can be set
+    cancelUnfinishedScan();
+    q->setOptionsMap(m_scanJobs.first().options);
+    m_scanJobOptionsApplied = m_scanJobs.first().id;
+}
+
+void InterfacePrivate::cancelUnfinishedScan()
+{
+    // a scan read up to the end of its last frame has already left the scanning state,
+    // the worker is used since it might be accessing the handle meanwhile
+    if (m_scanThread->frameStatus() != ScanThread::ReadReady) {
+        m_optionWorker->cancelScan();
+    }
+}
+
+void InterfacePrivate::finishScanJob()
+{
+    if (m_currentScanJob.promise) {
+        m_currentScanJob.promise->finish();
+    }
+    m_currentScanJob = ScanJob();
+}
+
+QSizeF InterfacePrivate::scanResolution() const
+{
+    Option *resolutionOption = q->getOption(Interface::ResolutionOption);
+    Option *xResolutionOption = q->getOption(Interface::XResolutionOption);
+    Option *yResolutionOption = q->getOption(Interface::YResolutionOption);
+    double xResolution = 0;
+    if (resolutionOption != nullptr) {
+        xResolution = resolutionOption->value().toDouble();
+    } else if (xResolutionOption != nullptr) {
+        xResolution = xResolutionOption->value().toDouble();
+    }
+    const double yResolution = yResolutionOption != nullptr ? yResolutionOption->value().toDouble() : xResolution;
+    if (xResolution <= 0 || yResolution <= 0) {
+        return QSizeF();
+    }
+    return QSizeF(xResolution, yResolution);
+}
+
+QMap<QString, QString> InterfacePrivate::imageOptionValues() const
+{
+    QMap<QString, QString> options = q->getOptionsMap();
+    // the preview uses its own values of these options, they are compared separately
+    const QList<Interface::OptionName> previewOptions = {Interface::PreviewOption,
+                                                         Interface::TopLeftXOption,
+                                                         Interface::TopLeftYOption,
+                                                         Interface::BottomRightXOption,
+                                                         Interface::BottomRightYOption,
+                                                         Interface::PageSizeOption,
+                                                         Interface::ResolutionOption,
+                                                         Interface::XResolutionOption,
+                                                         Interface::YResolutionOption,
+                                                         Interface::BitDepthOption};
+    for (const Interface::OptionName name : previewOptions) {
+        Option *option = q->getOption(name);
+        if (option != nullptr) {
+            options.remove(option->name());
+        }
+    }
+    return options;
+}
+
+void InterfacePrivate::storePreviewCache(const QImage &image)
+{
+    m_previewCache = PreviewCache();
+    Option *topLeftXOption = q->getOption(Interface::TopLeftXOption);
+    Option *topLeftYOption = q->getOption(Interface::TopLeftYOption);
+    Option *bottomRightXOption = q->getOption(Interface::BottomRightXOption);
+    Option *bottomRightYOption = q->getOption(Interface::BottomRightYOption);
+    // processed previews do not cover the scan area anymore
+    if (!m_reusePreviewScan || m_cropToContent || m_deskew || m_reduceColors || topLeftXOption == nullptr || topLeftYOption == nullptr
+        || bottomRightXOption == nullptr || bottomRightYOption == nullptr || topLeftXOption->valueUnit() != Option::UnitMilliMeter) {
+        return;
+    }
+    const QSizeF resolution = scanResolution();
+    if (resolution.isEmpty()) {
+        return;
+    }
+
+    Option *scanModeOption = q->getOption(Interface::ScanModeOption);
+    Option *bitDepthOption = q->getOption(Interface::BitDepthOption);
+    m_previewCache.image = image;
+    m_previewCache.area = QRectF(QPointF(topLeftXOption->value().toDouble(), topLeftYOption->value().toDouble()),
+                                 QPointF(bottomRightXOption->value().toDouble(), bottomRightYOption->value().toDouble()));
+    m_previewCache.resolution = resolution;
+    m_previewCache.mode = scanModeOption != nullptr ? scanModeOption->value().toString() : QString();
+    m_previewCache.depth = bitDepthOption != nullptr ? bitDepthOption->value().toInt() : 0;
+    m_previewCache.options = imageOptionValues();
+}
+
+bool InterfacePrivate::servePreviewCache()
+{
+    if (m_previewCache.image.isNull() || m_previewScan || m_regionScan || m_executeMultiPageScanning || m_waitForExternalButton
+        || (m_batchMode != nullptr && m_batchMode->value().toBool())) {
+        return false;
+    }
+    // any change of an option affecting the image invalidates the preview
+    if (imageOptionValues() != m_previewCache.options) {
+        m_previewCache = PreviewCache();
+        return false;
+    }
+
+    Option *topLeftXOption = q->getOption(Interface::TopLeftXOption);
+    Option *topLeftYOption = q->getOption(Interface::TopLeftYOption);
+    Option *bottomRightXOption = q->getOption(Interface::BottomRightXOption);
+    Option *bottomRightYOption = q->getOption(Interface::BottomRightYOption);
+    Option *scanModeOption = q->getOption(Interface::ScanModeOption);
+    Option *bitDepthOption = q->getOption(Interface::BitDepthOption);
+    if (topLeftXOption == nullptr || topLeftYOption == nullptr || bottomRightXOption == nullptr || bottomRightYOption == nullptr) {
+        return false;
+    }
+    const QRectF area(QPointF(topLeftXOption->value().toDouble(), topLeftYOption->value().toDouble()),
+                      QPointF(bottomRightXOption->value().toDouble(), bottomRightYOption->value().toDouble()));
+    const QSizeF resolution = scanResolution();
+    const QString mode = scanModeOption != nullptr ? scanModeOption->value().toString() : QString();
+    const int depth = bitDepthOption != nullptr ? bitDepthOption->value().toInt() : 0;
+    const bool deepPreview = m_previewCache.image.depth() == 16 || m_previewCache.image.depth() == 64;
+    if (area.isEmpty() || !m_previewCache.area.contains(area) || resolution.isEmpty() || resolution.width() > m_previewCache.resolution.width()
+        || resolution.height() > m_previewCache.resolution.height() || mode != m_previewCache.mode
+        || (depth != m_previewCache.depth && !(deepPreview && depth == 8))) {
+        return false;
+    }
+
+    // the cropped image shares the data with the preview if the resolution is the same
+    const double pixelsPerMillimeterX = m_previewCache.resolution.width() / 25.4;
+    const double pixelsPerMillimeterY = m_previewCache.resolution.height() / 25.4;
+    const QRect previewArea = QRectF((area.left() - m_previewCache.area.left()) * pixelsPerMillimeterX,
+                                     (area.top() - m_previewCache.area.top()) * pixelsPerMillimeterY,
+                                     area.width() * pixelsPerMillimeterX,
+                                     area.height() * pixelsPerMillimeterY)
+                                  .toAlignedRect();
+    QImage image = ImageProcessor::subImage(m_previewCache.image, previewArea);
+    if (resolution != m_previewCache.resolution) {
+        const QSize size(qMax(qRound(area.width() * resolution.width() / 25.4), 1), qMax(qRound(area.height() * resolution.height() / 25.4), 1));
+        const bool mono = image.format() == QImage::Format_Mono;
+        image = image.scaled(size, Qt::IgnoreAspectRatio, mono ? Qt::FastTransformation : Qt::SmoothTransformation);
+        image.setDotsPerMeterX(qRound(resolution.width() * 1000 / 25.4));
+        image.setDotsPerMeterY(qRound(resolution.height() * 1000 / 25.4));
+    }
+    if (image.format() == QImage::Format_RGBX64 && depth == 8) {
+        image = image.convertToFormat(QImage::Format_RGB32);
+    } else if (image.format() == QImage::Format_Grayscale16 && depth == 8) {
+        image = image.convertToFormat(QImage::Format_Grayscale8);
+    }
+
+    // delivered like a scan, the image is analyzed on the thread pool and delivered after the caller has returned
+    m_servingPreviewCache = true;
+    const int serial = ++m_previewCacheSerial;
+    emitProgress(-1);
+    auto analysis = std::make_shared<QPromise<QVariantMap>>();
+    analysis->start();
+    analysis->future().then(this, [this, image, serial](const QVariantMap &metadata) {
+        if (!m_servingPreviewCache || serial != m_previewCacheSerial) {
+            // stopped in the meantime
+            return;
+        }
+        m_servingPreviewCache = false;
+        emitProgress(100);
+        if (!m_skipBlankPages || !metadata.value(QStringLiteral("blankPage")).toBool()) {
+            deliverScannedImage(image, metadata, true);
+        }
+        scanIsFinished(Interface::NoError, QString());
+    });
+    QThreadPool::globalInstance()->start([analysis,
+                                          image,
+                                          inkRatio = m_blankPageInkRatio,
+                                          margin = m_blankPageMargin,
+                                          hashing = pageHashingEnabled(),
+                                          analyses = pageAnalyses()]() {
+        PageAnalyzer analyzer;
+        analyzer.setBlankPageDetection(inkRatio, margin);
+        analyzer.setHashing(hashing);
+        analyzer.setAnalyses(analyses);
+        analyzer.start(image, image.height());
+        analyzer.analyzeRows(image, 0, image.height());
+        analyzer.finish();
+        analysis->addResult(analyzer.metadata());
+        analysis->finish();
+    });
+    return true;
+}
+
 } // NameSpace KSaneCore
 
 #include "moc_interface_p.cpp"
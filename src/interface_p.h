@@ -9,9 +9,15 @@
 #ifndef KSANE_CORE_PRIVATE_H
 #define KSANE_CORE_PRIVATE_H
 
+#include <memory>
+
 #include <QHash>
 #include <QList>
+#include <QMap>
+#include <QPromise>
+#include <QRectF>
 #include <QSet>
+#include <QSizeF>
 #include <QTime>
 #include <QTimer>
 #include <QVarLengthArray>
@@ -19,8 +25,11 @@
 
 #include "authentication.h"
 #include "baseoption.h"
+#include "duplicatepagedetector.h"
 #include "finddevicesthread.h"
 #include "interface.h"
+#include "optionworker.h"
+#include "pageanalyzer.h"
 #include "scanthread.h"
 
 /** This namespace collects all methods and classes in LibKSane. */
@@ -37,11 +46,43 @@ public:
     void clearDeviceOptions();
     void setDefaultValues();
     void scanIsFinished(Interface::ScanStatus status, const QString &message);
+    void startScanThread();
+    void writePendingGammaTables();
+    void releaseDevice();
+    bool parkDevice();
+    bool reopenParkedDevice(const QString &deviceName);
+    void swapParkedDevice();
+    void enableOptionPolling();
+    BaseOption *deviceOption(int index) const;
+    BaseOption *workerOption(int index) const;
+    void connectOptionWorker();
+    bool isScanning() const;
+    void stopScanning();
+    struct ScanJob;
+    void enqueueScanJob(ScanJob &&job);
+    void applyNextScanJobOptions();
+    void cancelUnfinishedScan();
+    void deliverScannedImage(const QImage &image, const QVariantMap &metadata, bool lastPage);
+    void storeContentScanArea(const QImage &image, const QVariantMap &metadata);
+    void applyContentScanArea();
+    void finishScanJob();
+    QSizeF scanResolution() const;
+    bool pageHashingEnabled() const;
+    PageAnalyzer::Analyses pageAnalyses() const;
+    QMap<QString, QString> imageOptionValues() const;
+    void storePreviewCache(const QImage &image);
+    bool servePreviewCache();
 
 public Q_SLOTS:
     void devicesListUpdated();
     void signalDevicesListUpdate();
+    void signalCachedDevicesList();
+    void signalLocalDevices(const QList<DeviceInformation *> &addedDevices);
+    void discoveryTimedOut();
+    void releaseParkedDevice();
+    void startNextScanJob();
     void imageScanFinished();
+    void pageScanned(const QImage &image, const QVariantMap &metadata);
     void scheduleValuesReload();
     void reloadOptions();
     void reloadValues();
@@ -54,8 +95,12 @@ Q_SIGNALS:
 private Q_SLOTS:
     void determineMultiPageScanning(const QVariant &value);
     void setWaitForExternalButton(const QVariant &value);
-    void pollPollOptions();
     void batchModeTimerUpdate();
+    void applyValueData(int index, const QByteArray &data, int serial);
+    void storeValueData(int index, const QByteArray &data);
+    void applyPolledValue(int index, const QByteArray &data);
+    void valueWritten(int index, int status, int info);
+    void optionWorkerIdle();
 
 public:
     // device info
@@ -70,14 +115,56 @@ public:
     QHash<Interface::OptionName, int> m_optionsLocation;
     QList<BaseOption *> m_optionsPollList;
     QTimer m_readValuesTimer;
-    QTimer m_optionPollTimer;
-    bool m_optionPollingNaughtylisted = false;
+    // the last option whose write requested a values reload, its own value is known
+    BaseOption *m_valuesReloadTrigger = nullptr;
 
     QString m_saneUserName;
     QString m_sanePassword;
 
     ScanThread *m_scanThread = nullptr;
+    OptionWorker *m_optionWorker = nullptr;
+    QThread::Priority m_scanThreadPriority = QThread::InheritPriority;
+    QList<int> m_scanThreadAffinity;
+    int m_progressStep = 1;
+    int m_progressInterval = 100;
+    int m_maxPendingPages = 0;
+    double m_blankPageInkRatio = 0.005;
+    int m_blankPageMargin = 5;
+    bool m_skipBlankPages = false;
+    bool m_reduceColors = false;
+    bool m_cropToContent = false;
+    bool m_deskew = false;
+    QList<int> m_reductionFactors;
+    bool m_pageHashing = false;
+    DuplicatePageDetector m_duplicatePageDetector;
+    int m_duplicatePageCount = 0;
+    bool m_adjustScanArea = false;
+    // the scan area in millimeters covering the content of the last image
+    QRectF m_contentScanArea;
+    // only the regions of the scanned image are delivered
+    bool m_regionScan = false;
+    // the last preview image and the values it was scanned with, compatible scans are cropped from it
+    struct PreviewCache {
+        QImage image;
+        QRectF area;
+        QSizeF resolution;
+        QString mode;
+        int depth = 0;
+        QMap<QString, QString> options;
+    };
+    PreviewCache m_previewCache;
+    bool m_reusePreviewScan = false;
+    bool m_servingPreviewCache = false;
+    // identifies the latest served preview, the analysis of an earlier one might still finish
+    int m_previewCacheSerial = 0;
+    bool m_asynchronousOptionAccess = false;
+    int m_gammaWriteDelay = 0;
+    // the scan is started as soon as the pending option reads are finished
+    bool m_scanWaitingForOptionWorker = false;
     FindSaneDevicesThread *m_findDevThread;
+    // the devices list has to be reported even if the refresh did not change it
+    bool m_devicesListRequested = false;
+    QTimer m_discoveryTimer;
     Authentication *m_auth;
     Interface *q;
 
@@ -96,6 +183,45 @@ public:
     BaseOption *m_batchModeDelay = nullptr;
     QTimer m_batchModeTimer;
     int m_batchModeCounter = 0;
+
+    // a closed device which is kept open for a fast reopen
+    struct ParkedDevice {
+        SANE_Handle saneHandle = nullptr;
+        QString devName;
+        QString vendor;
+        QString model;
+        QList<BaseOption *> optionsList;
+        QList<Option *> externalOptionsList;
+        QHash<Interface::OptionName, int> optionsLocation;
+        QList<BaseOption *> optionsPollList;
+        QMap<QString, QString> initialOptionValues;
+        ScanThread *scanThread = nullptr;
+        OptionWorker *optionWorker = nullptr;
+        BaseOption *batchMode = nullptr;
+        BaseOption *batchModeDelay = nullptr;
+        bool executeMultiPageScanning = false;
+        bool waitForExternalButton = false;
+    };
+    ParkedDevice m_parkedDevice;
+    // the option values after opening the device, they are restored when a parked device is reopened
+    QMap<QString, QString> m_initialOptionValues;
+    int m_keepAliveTime = 0;
+    QTimer m_keepAliveTimer;
+
+    // scan jobs are executed one after the other, the queue is sorted by priority
+    struct ScanJob {
+        int id = 0;
+        int priority = 0;
+        QMap<QString, QString> options;
+        std::shared_ptr<QPromise<QImage>> promise;
+        int pages = 0;
+    };
+    QList<ScanJob> m_scanJobs;
+    ScanJob m_currentScanJob;
+    int m_lastScanJobId = 0;
+    bool m_applyScanJobOptionsEarly = false;
+    // the job whose options have already been applied while the previous job was finishing
+    int m_scanJobOptionsApplied = 0;
 };
 
 } // NameSpace KSaneCore
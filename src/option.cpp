@@ -147,6 +147,15 @@ bool Option::setValue(const QVariant &value)
     }
 }
 
+QFuture<bool> Option::setValueAsync(const QVariant &value)
+{
+    if (d->option != nullptr) {
+        return d->option->setValueAsync(value);
+    } else {
+        return BaseOption::finishedFuture(false);
+    }
+}
+
 bool Option::storeCurrentData()
 {
     if (d->option != nullptr) {
@@ -12,6 +12,7 @@
 // Qt includes
 
 #include "ksanecore_export.h"
+#include <QFuture>
 #include <QObject>
 #include <QString>
 #include <QVariant>
@@ -130,6 +131,15 @@ public:
      * and makes it the current value. */
     bool restoreSavedData();
 
+    /** This function changes the current value of the option like setValue(),
+     * but allows to wait for the value to be written to the device.
+     * With asynchronous option access enabled, see Interface::setAsynchronousOptionAccess(),
+     * the write is executed on a worker thread and the future finishes once it is done.
+     * @param value the new value of option inside a QVariant.
+     * @return a future holding whether the device accepted the value
+     * @since 25.04 */
+    QFuture<bool> setValueAsync(const QVariant &value);
+
 Q_SIGNALS:
     /** This signal is emitted when the option is reloaded, which may
      * happen if the value of other options has changed. */
@@ -11,6 +11,8 @@
 
 #include <ksanecore_debug.h>
 
+#include "optionworker.h"
+
 namespace KSaneCore
 {
 
@@ -31,6 +33,29 @@ BaseOption::~BaseOption()
     }
 }
 
+void BaseOption::setOptionWorker(OptionWorker *worker)
+{
+    m_worker = worker;
+}
+
+int BaseOption::index() const
+{
+    return m_index;
+}
+
+int BaseOption::writeCount() const
+{
+    return m_writeCount;
+}
+
+int BaseOption::valueDataSize() const
+{
+    if (m_optDesc == nullptr) {
+        return 0;
+    }
+    return m_optDesc->size;
+}
+
 void BaseOption::readOption()
 {
     beginOptionReload();
@@ -39,7 +64,10 @@ void BaseOption::readOption()
 
 void BaseOption::beginOptionReload()
 {
-    if (m_handle != nullptr) {
+    if (m_worker != nullptr) {
+        // the worker might be inside sane_control_option
+        m_optDesc = m_worker->optionDescriptor(m_index);
+    } else if (m_handle != nullptr) {
         m_optDesc = sane_get_option_descriptor(m_handle, m_index);
     }
 }
@@ -77,6 +105,35 @@ bool BaseOption::needsPolling() const
     return false;
 }
 
+bool BaseOption::hasReadableValue() const
+{
+    if (m_handle == nullptr || m_optDesc == nullptr) {
+        return false;
+    }
+    if (m_optionType == Option::TypeDetectFail || m_optionType == Option::TypeAction) {
+        return false;
+    }
+    return BaseOption::state() != Option::StateHidden;
+}
+
+bool BaseOption::hasConstantValue() const
+{
+    if (m_optDesc == nullptr) {
+        return true;
+    }
+
+    switch (m_optDesc->constraint_type) {
+    case SANE_CONSTRAINT_RANGE:
+        return m_optDesc->constraint.range->min == m_optDesc->constraint.range->max;
+    case SANE_CONSTRAINT_WORD_LIST:
+        return m_optDesc->constraint.word_list[0] <= 1;
+    case SANE_CONSTRAINT_STRING_LIST:
+        return m_optDesc->constraint.string_list[0] == nullptr || m_optDesc->constraint.string_list[1] == nullptr;
+    default:
+        return false;
+    }
+}
+
 QString BaseOption::name() const
 {
     if (m_optDesc == nullptr) {
@@ -106,6 +163,19 @@ Option::OptionType BaseOption::type() const
     return m_optionType;
 }
 
+SANE_Status BaseOption::controlOption(SANE_Action action, void *data, SANE_Int *info)
+{
+    if (m_worker != nullptr) {
+        return m_worker->controlOption(m_index, action, data, info);
+    }
+    return sane_control_option(m_handle, m_index, action, data, info);
+}
+
+bool BaseOption::isAsynchronous() const
+{
+    return m_worker != nullptr && m_worker->isAsynchronous();
+}
+
 bool BaseOption::writeData(void *data)
 {
     SANE_Status status;
@@ -115,7 +185,28 @@ bool BaseOption::writeData(void *data)
         return false;
     }
 
-    status = sane_control_option(m_handle, m_index, SANE_ACTION_SET_VALUE, data, &res);
+    m_writeCount++;
+    if (isAsynchronous()) {
+        // the result is handled in writeFinished() once the worker has executed the write
+        int size = m_optDesc->size;
+        if (m_optDesc->type == SANE_TYPE_STRING) {
+            size = static_cast<int>(qstrnlen(static_cast<const char *>(data), m_optDesc->size - 1)) + 1;
+        }
+        QByteArray buffer(m_optDesc->size, 0);
+        if (data != nullptr) {
+            memcpy(buffer.data(), data, size);
+        }
+        m_writeFuture = m_worker->queueWrite(m_index, buffer);
+        return true;
+    }
+
+    status = controlOption(SANE_ACTION_SET_VALUE, data, &res);
+    m_writeFuture = finishedFuture(status == SANE_STATUS_GOOD);
+    return writeFinished(status, res);
+}
+
+bool BaseOption::writeFinished(SANE_Status status, SANE_Int res)
+{
     if (status != SANE_STATUS_GOOD) {
         qCDebug(KSANECORE_LOG) << m_optDesc->name << "sane_control_option returned:" << sane_strstatus(status);
         // write failed. re read the current setting
@@ -138,9 +229,32 @@ bool BaseOption::writeData(void *data)
     return true;
 }
 
-void BaseOption::readValue() {}
+void BaseOption::readValue()
+{
+    if (!hasReadableValue()) {
+        return;
+    }
+
+    if (isAsynchronous()) {
+        // the value is passed to applyValueData() once the worker has read it
+        m_worker->queueRead(m_index, m_optDesc->size, m_writeCount);
+        return;
+    }
+
+    // read the current value
+    QByteArray data(m_optDesc->size, 0);
+    SANE_Status status;
+    SANE_Int res;
+    status = controlOption(SANE_ACTION_GET_VALUE, data.data(), &res);
+    if (status != SANE_STATUS_GOOD) {
+        return;
+    }
+    applyValueData(data);
+}
+
+void BaseOption::applyValueData(const QByteArray &) {}
 
-SANE_Word BaseOption::toSANE_Word(unsigned char *data)
+SANE_Word BaseOption::toSANE_Word(const unsigned char *data)
 {
     SANE_Word tmp;
     // if __BYTE_ORDER is not defined we get #if 0 == 0
@@ -246,6 +360,26 @@ bool BaseOption::setValue(const QVariant &)
     return false;
 }
 
+QFuture<bool> BaseOption::setValueAsync(const QVariant &value)
+{
+    m_writeFuture = QFuture<bool>();
+    const bool success = setValue(value);
+    if (success && m_writeFuture.isValid()) {
+        return m_writeFuture;
+    }
+    // nothing has been written to the device
+    return finishedFuture(success);
+}
+
+QFuture<bool> BaseOption::finishedFuture(bool result)
+{
+    QPromise<bool> promise;
+    promise.start();
+    promise.addResult(result);
+    promise.finish();
+    return promise.future();
+}
+
 bool BaseOption::storeCurrentData()
 {
     SANE_Status status;
@@ -256,12 +390,18 @@ bool BaseOption::storeCurrentData()
         return false;
     }
 
+    if (isAsynchronous()) {
+        // the value is passed to storeValueData() once the worker has read it
+        m_worker->queueStore(m_index, m_optDesc->size);
+        return true;
+    }
+
     // read that current value
     if (m_data != nullptr) {
         free(m_data);
     }
     m_data = (unsigned char *)malloc(m_optDesc->size);
-    status = sane_control_option(m_handle, m_index, SANE_ACTION_GET_VALUE, m_data, &res);
+    status = controlOption(SANE_ACTION_GET_VALUE, m_data, &res);
     if (status != SANE_STATUS_GOOD) {
         qCDebug(KSANECORE_LOG) << m_optDesc->name << "sane_control_option returned" << status;
         return false;
@@ -269,6 +409,15 @@ bool BaseOption::storeCurrentData()
     return true;
 }
 
+void BaseOption::storeValueData(const QByteArray &data)
+{
+    if (m_data != nullptr) {
+        free(m_data);
+    }
+    m_data = (unsigned char *)malloc(data.size());
+    memcpy(m_data, data.constData(), data.size());
+}
+
 bool BaseOption::restoreSavedData()
 {
     // check if we have saved any data
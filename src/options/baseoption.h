@@ -9,6 +9,8 @@
 #define KSANE_BASE_OPTION_H
 
 // Qt includes
+#include <QByteArray>
+#include <QFuture>
 #include <QObject>
 
 //KDE includes
@@ -29,6 +31,8 @@ extern "C"
 namespace KSaneCore
 {
 
+class OptionWorker;
+
 inline QString sane_i18n(const char *text) {
     return i18nd(SANE_TRANSLATION_DOMAIN, text);
 }
@@ -45,9 +49,18 @@ public:
     ~BaseOption() override;
     static Option::OptionType optionType(const SANE_Option_Descriptor *optDesc);
 
+    void setOptionWorker(OptionWorker *worker);
+    int index() const;
+    int writeCount() const;
+    int valueDataSize() const;
+
     bool needsPolling() const;
+    bool hasReadableValue() const;
+    bool hasConstantValue() const;
     virtual void readOption();
-    virtual void readValue();
+    void readValue();
+    virtual void applyValueData(const QByteArray &data);
+    bool writeFinished(SANE_Status status, SANE_Int res);
 
 
     virtual QString name() const;
@@ -66,8 +79,12 @@ public:
     virtual QString valueAsString() const;
 
     bool storeCurrentData();
+    void storeValueData(const QByteArray &data);
     bool restoreSavedData();
 
+    QFuture<bool> setValueAsync(const QVariant &value);
+    static QFuture<bool> finishedFuture(bool result);
+
 Q_SIGNALS:
     void optionsNeedReload();
     void valuesNeedReload();
@@ -80,16 +97,21 @@ public Q_SLOTS:
 
 protected:
 
-    static SANE_Word toSANE_Word(unsigned char *data);
+    static SANE_Word toSANE_Word(const unsigned char *data);
     static void fromSANE_Word(unsigned char *data, SANE_Word from);
+    SANE_Status controlOption(SANE_Action action, void *data, SANE_Int *info);
+    bool isAsynchronous() const;
     bool writeData(void *data);
     void beginOptionReload();
     void endOptionReload();
 
     SANE_Handle                   m_handle = nullptr;
+    OptionWorker                 *m_worker = nullptr;
     int                           m_index = -1;
+    int                           m_writeCount = 0;
     const SANE_Option_Descriptor *m_optDesc = nullptr; ///< This pointer is provided by sane
     unsigned char                *m_data= nullptr;
+    QFuture<bool>                 m_writeFuture;
     Option::OptionType m_optionType = Option::TypeDetectFail;
 };
 
@@ -7,8 +7,6 @@
 
 #include "booloption.h"
 
-#include <QVarLengthArray>
-
 #include <ksanecore_debug.h>
 
 namespace KSaneCore
@@ -39,22 +37,10 @@ bool BoolOption::setValue(const QVariant &value)
     return true;
 }
 
-void BoolOption::readValue()
+void BoolOption::applyValueData(const QByteArray &data)
 {
-    if (state() == Option::StateHidden) {
-        return;
-    }
-
-    // read the current value
-    QVarLengthArray<unsigned char> data(m_optDesc->size);
-    SANE_Status status;
-    SANE_Int res;
-    status = sane_control_option(m_handle, m_index, SANE_ACTION_GET_VALUE, data.data(), &res);
-    if (status != SANE_STATUS_GOOD) {
-        return;
-    }
     bool old = m_checked;
-    m_checked = (toSANE_Word(data.data()) != 0) ? true : false;
+    m_checked = (toSANE_Word(reinterpret_cast<const unsigned char *>(data.constData())) != 0) ? true : false;
 
     if ((old != m_checked) && ((m_optDesc->cap & SANE_CAP_SOFT_SELECT) == 0)) {
         Q_EMIT valueChanged(m_checked);
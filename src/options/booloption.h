@@ -19,7 +19,7 @@ class BoolOption : public BaseOption
 public:
     BoolOption(const SANE_Handle handle, const int index);
 
-    void readValue() override;
+    void applyValueData(const QByteArray &data) override;
 
     QVariant value() const override;
     QString valueAsString() const override;
@@ -8,8 +8,6 @@
 
 #include "doubleoption.h"
 
-#include <QVarLengthArray>
-
 #include <ksanecore_debug.h>
 
 static const double FIXED_MAX = 32767.9999;
@@ -42,22 +40,9 @@ void DoubleOption::readOption()
     endOptionReload();
 }
 
-void DoubleOption::readValue()
+void DoubleOption::applyValueData(const QByteArray &data)
 {
-    if (state() == Option::StateHidden) {
-        return;
-    }
-
-    // read that current value
-    QVarLengthArray<unsigned char> data(m_optDesc->size);
-    SANE_Status status;
-    SANE_Int res;
-    status = sane_control_option(m_handle, m_index, SANE_ACTION_GET_VALUE, data.data(), &res);
-    if (status != SANE_STATUS_GOOD) {
-        return;
-    }
-
-    double newValue = SANE_UNFIX(toSANE_Word(data.data()));
+    double newValue = SANE_UNFIX(toSANE_Word(reinterpret_cast<const unsigned char *>(data.constData())));
     if (abs(newValue - m_value) >= FIXED_PRECISION) {
         m_value = newValue;
         Q_EMIT valueChanged(m_value);
@@ -20,7 +20,7 @@ class DoubleOption : public BaseOption
 public:
     DoubleOption(const SANE_Handle handle, const int index);
 
-    void readValue() override;
+    void applyValueData(const QByteArray &data) override;
     void readOption() override;
 
     QVariant minimumValue() const override;
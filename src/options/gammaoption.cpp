@@ -7,12 +7,16 @@
 
 #include "gammaoption.h"
 
-#include <QVarLengthArray>
-
 #include <ksanecore_debug.h>
 
+#include <QVarLengthArray>
+
+#include <algorithm>
 #include <cmath>
 
+// maximum number of table entries used to fit brightness, contrast and gamma
+static const int GAMMA_FIT_SAMPLES = 256;
+
 namespace KSaneCore
 {
 
@@ -20,6 +24,8 @@ GammaOption::GammaOption(const SANE_Handle handle, const int index)
     : BaseOption(handle, index)
 {
     m_optionType = Option::TypeGamma;
+    m_writeTimer.setSingleShot(true);
+    connect(&m_writeTimer, &QTimer::timeout, this, &GammaOption::writePendingData);
 }
 
 bool GammaOption::setValue(const QVariant &value)
@@ -71,31 +77,37 @@ bool GammaOption::setValue(const QVariant &value)
     return false;
 }
 
-void GammaOption::readValue()
+void GammaOption::applyValueData(const QByteArray &data)
 {
-    if (state() == Option::StateHidden) {
+    if (m_pendingWrite) {
+        // the device still has the old table
         return;
     }
-
-    QVarLengthArray<unsigned char> data(m_optDesc->size);
-    SANE_Status status;
-    SANE_Int res;
-    status = sane_control_option(m_handle, m_index, SANE_ACTION_GET_VALUE, data.data(), &res);
-    if (status != SANE_STATUS_GOOD) {
+    const int size = data.size() / sizeof(SANE_Word);
+    const size_t hash = qHash(QByteArrayView(data));
+    if (size == m_gammaTable.size() && hash == m_gammaTableHash) {
+        // same table as before, no need to fit the values again
         return;
     }
+    m_gammaTableHash = hash;
+
+    // decode into the existing buffer, it only reallocates when the size changes
+    const unsigned char *rawData = reinterpret_cast<const unsigned char *>(data.constData());
+    m_gammaTable.resize(size);
+    int *table = m_gammaTable.data();
+    for (int i = 0; i < size; i++) {
+        table[i] = toSANE_Word(&rawData[i * sizeof(SANE_Word)]);
+    }
 
-    QVector<int> gammaTable;
-    gammaTable.reserve(data.size() / sizeof(int));
-    for (int i = 0; i < data.size(); i += sizeof(SANE_Word)) gammaTable.append(toSANE_Word(&data[i]));
-
-    if (gammaTable != m_gammaTable) {
-        m_gammaTable = gammaTable;
+    m_gammaTableMax = m_optDesc->constraint.range->max;
 
-        m_gammaTableMax = m_optDesc->constraint.range->max;
+    calculateBCGwriteData();
+}
 
-        calculateBCGwriteData();
-    }
+size_t GammaOption::gammaTableHash() const
+{
+    // the table holds the words in host byte order like the raw device data
+    return qHash(QByteArrayView(reinterpret_cast<const char *>(m_gammaTable.constData()), m_gammaTable.size() * sizeof(SANE_Word)));
 }
 
 QVariant GammaOption::value() const
@@ -130,121 +142,206 @@ QString GammaOption::valueAsString() const
     return QString::asprintf("%d:%d:%d", m_brightness, m_contrast, m_gamma);
 }
 
-void GammaOption::calculateGTwriteData()
+void GammaOption::updateGammaCurve(double maxValue)
 {
-    double maxValue = m_optDesc->constraint.range->max;
-    double gamma    = 100.0 / m_gamma;
-    double contrast = (200.0 / (100.0 - m_contrast)) - 1;
-    double halfMax  = maxValue / 2.0;
-    // NOTE: This used to add the value times 2, not scaled to maxValue
-    double brightness = m_brightness * maxValue / 100.0;
-    double x;
+    const int size = m_gammaTable.size();
+    if (m_gammaCurve.size() == size && m_gammaCurveGamma == m_gamma && m_gammaCurveMax == maxValue) {
+        return;
+    }
 
-    for (int i = 0; i < m_gammaTable.size(); i++) {
-        // apply gamma
-        x = std::pow(static_cast<double>(i) / m_gammaTable.size(), gamma) * maxValue;
+    // the logarithms only depend on the table size, a new gamma only needs one exp per entry
+    if (m_logTable.size() != size) {
+        m_logTable.resize(size);
+        for (int i = 0; i < size; i++) {
+            m_logTable[i] = std::log(static_cast<double>(i) / size);
+        }
+    }
 
-        // apply contrast
-        x = (contrast * (x - halfMax)) + halfMax;
+    m_gammaCurve.resize(size);
+    for (int i = 0; i < size; i++) {
+        m_gammaCurve[i] = gammaCurveValue(m_logTable[i], m_gamma, maxValue);
+    }
+    m_gammaCurveGamma = m_gamma;
+    m_gammaCurveMax = maxValue;
+}
 
-        // apply brightness + rounding
-        x += brightness + 0.5;
+double GammaOption::gammaCurveValue(double logPosition, int gamma, double maxValue)
+{
+    return std::exp(100.0 / gamma * logPosition) * maxValue;
+}
 
-        // ensure correct value
-        if (x > maxValue) {
-            x = maxValue;
-        }
-        if (x < 0) {
-            x = 0;
-        }
+void GammaOption::applyBrightnessContrast(const QVector<double> &curve, int brightness, int contrast, double maxValue, QVector<int> &table)
+{
+    const double contrastFactor = (200.0 / (100.0 - contrast)) - 1;
+    const double halfMax = maxValue / 2.0;
+    // NOTE: This used to add the value times 2, not scaled to maxValue
+    // the offset includes the rounding
+    const double offset = brightness * maxValue / 100.0 + 0.5;
+
+    const double *curveData = curve.constData();
+    int *tableData = table.data();
+    const int size = table.size();
+    for (int i = 0; i < size; i++) {
+        // apply contrast and brightness and ensure correct value
+        const double x = contrastFactor * (curveData[i] - halfMax) + halfMax + offset;
+        tableData[i] = static_cast<int>(std::clamp(x, 0.0, maxValue));
+    }
+}
 
-        m_gammaTable[i] = static_cast<int>(x);
+QVector<int> GammaOption::gammaTable(int brightness, int contrast, int gamma, int size, double maxValue)
+{
+    // a contrast of 100 would divide by zero and a gamma of 0 would not be a curve
+    brightness = std::clamp(brightness, MIN_BRIGHTNESS, MAX_BRIGHTNESS);
+    contrast = std::clamp(contrast, MIN_CONTRAST, MAX_CONTRAST);
+    gamma = std::clamp(gamma, MIN_GAMMA, MAX_GAMMA);
+
+    QVector<double> curve(size);
+    for (int i = 0; i < size; i++) {
+        curve[i] = gammaCurveValue(std::log(static_cast<double>(i) / size), gamma, maxValue);
     }
+    QVector<int> table(size);
+    applyBrightnessContrast(curve, brightness, contrast, maxValue, table);
+    return table;
+}
 
-    writeData(m_gammaTable.data());
+void GammaOption::calculateGTwriteData()
+{
+    const double maxValue = m_optDesc->constraint.range->max;
+
+    updateGammaCurve(maxValue);
+    applyBrightnessContrast(m_gammaCurve, m_brightness, m_contrast, maxValue, m_gammaTable);
+    m_gammaTableHash = gammaTableHash();
+
+    scheduleWrite();
     QVariantList values = { m_brightness, m_contrast, m_gamma };
     Q_EMIT valueChanged(values);
 }
 
-void GammaOption::calculateBCGwriteData() {
+void GammaOption::scheduleWrite()
+{
+    if (!m_pendingWrite) {
+        m_pendingWrite = std::make_shared<QPromise<bool>>();
+        m_pendingWrite->start();
+    }
+    m_writeFuture = m_pendingWrite->future();
+    if (m_writeDelay > 0) {
+        m_writeTimer.start(m_writeDelay);
+    } else {
+        writePendingData();
+    }
+}
+
+void GammaOption::setWriteDelay(int msecs)
+{
+    m_writeDelay = msecs;
+    if (m_writeDelay <= 0) {
+        writePendingData();
+    }
+}
+
+void GammaOption::writePendingData()
+{
+    if (!m_pendingWrite) {
+        return;
+    }
+    m_writeTimer.stop();
+    std::shared_ptr<QPromise<bool>> promise = std::move(m_pendingWrite);
+
+    m_writeFuture = QFuture<bool>();
+    const bool success = writeData(m_gammaTable.data());
+    if (!m_writeFuture.isValid()) {
+        promise->addResult(success);
+        promise->finish();
+        return;
+    }
+    // resolve the future returned for the delayed write once the device has been written
+    m_writeFuture.then([promise](bool result) {
+        promise->addResult(result);
+        promise->finish();
+    });
+}
+
+void GammaOption::calculateBCGwriteData()
+{
+    const int size = m_gammaTable.size();
+    if (size == 0) {
+        return;
+    }
     int beginIndex = 0;
-    int endIndex = m_gammaTable.size() - 1;
+    int endIndex = size - 1;
     // Find the start and end of the curve, to skip the flat regions
     while (beginIndex < endIndex && m_gammaTable[beginIndex] == m_gammaTable[0])
         beginIndex++;
-    while (endIndex > beginIndex && m_gammaTable[endIndex] == m_gammaTable[m_gammaTable.size()-1])
+    while (endIndex > beginIndex && m_gammaTable[endIndex] == m_gammaTable[size - 1])
         endIndex--;
 
-    float gamma = 0, contrast = 0, brightness = 0;
-    const QVector<int> &gammaTable = m_gammaTable;
-    const int &gammaTableMax = m_gammaTableMax;
-
-    auto guessGamma = [&gammaTable, &gamma](int i1, int i2, int step) {
-        int diff1 = gammaTable[i1 + step] - gammaTable[i1 - step];
-        int diff2 = gammaTable[i2 + step] - gammaTable[i2 - step];
-        if (diff1 == 0 || diff2 == 0)
-            return;
-        float stepProportion = static_cast<float>(i2) / i1;
-        float diffProportion = static_cast<float>(diff2) / diff1;
-        float guessedGamma = log(stepProportion * diffProportion) / log(stepProportion);
-        gamma += guessedGamma;
-    };
-
-    auto guessContrast = [&gammaTable, &gammaTableMax, &gamma, &contrast](int i1, int i2, int) {
-        int prevVal = gammaTable[i1], nextVal = gammaTable[i2];
-        float scaledDiff = static_cast<float>(nextVal - prevVal) / gammaTableMax;
-        float scaledPrevIndex = static_cast<float>(i1) / gammaTable.size();
-        float scaledNextIndex = static_cast<float>(i2) / gammaTable.size();
-        float guessedContrast = scaledDiff / (pow(scaledNextIndex, gamma) - pow(scaledPrevIndex, gamma));
-        contrast += guessedContrast;
-    };
-
-    auto guessBrightness = [&gammaTable, &gammaTableMax, &gamma, &contrast, &brightness](int i, int, int) {
-        float scaledThisVal = static_cast<float>(gammaTable[i]) / gammaTableMax;
-        float scaledIndex = static_cast<float>(i) / gammaTable.size();
-        float guessedBrightness = scaledThisVal - ((pow(scaledIndex, gamma) - 0.5) * contrast + 0.5);
-        brightness += guessedBrightness;
-    };
-
-    const int numberOfApproximations = 16;
-
-    auto passValuePairsAndSteps = [&beginIndex, &endIndex](auto func) {
-        const int step = (endIndex - beginIndex) / 8;
-        for (int i = 0; i < numberOfApproximations;) {
-            // Calculate step, even if not passed to the function, to separate the samples
-            int i1 = rand() % (endIndex - beginIndex - 2 * step - 2) + beginIndex + step + 1;
-            int i2 = rand() % (endIndex - beginIndex - 2 * step - 2) + beginIndex + step + 1;
-            if (i2 - i1 >= 4 * step) {
-                func(i1, i2, step);
-                i++;
-            }
-        }
-    };
-
     if (endIndex == beginIndex) {
         qCDebug(KSANECORE_LOG()) << "Ignoring gamma table: horizontal line at" << m_gammaTable[0];
         setValue(QVariantList{0, 0, 100}); // Ignore the table, it's wrong
         return;
     }
 
-    if (endIndex - beginIndex <= 32) { // Table too small, make single guesses
-        if (endIndex - beginIndex > 4) { // Measurements don't overlap by just one value
-            guessGamma(beginIndex + 2, endIndex - 2, 2);
-        } else {
-            gamma = 1.0; // Assume linear gamma
+    // The table follows y = max * (contrast * (x^gamma - 0.5) + 0.5 + brightness) with x = i / size.
+    // The slope is proportional to x^(gamma - 1), so gamma is fitted as a line through the logarithms
+    // of the slopes. With gamma known, y is linear in x^gamma which gives contrast and brightness.
+    struct Sample {
+        double x;
+        double y;
+    };
+    QVarLengthArray<Sample, GAMMA_FIT_SAMPLES + 2> samples;
+
+    const int range = endIndex - beginIndex;
+    const int stride = (range + GAMMA_FIT_SAMPLES - 1) / GAMMA_FIT_SAMPLES;
+    // distance for the slopes, large enough to smooth out the rounding of the table
+    const int delta = std::max(1, range / 32);
+    double sumLogX = 0, sumLogSlope = 0, sumLogXX = 0, sumLogXSlope = 0;
+    int slopeCount = 0;
+
+    for (int i = beginIndex; i <= endIndex; i += stride) {
+        const double x = static_cast<double>(i) / size;
+        samples.append({x, static_cast<double>(m_gammaTable[i])});
+
+        if (range > 4 && i - delta >= beginIndex && i + delta <= endIndex && i > 0) {
+            const int diff = m_gammaTable[i + delta] - m_gammaTable[i - delta];
+            if (diff > 0) {
+                const double logX = std::log(x);
+                const double logSlope = std::log(static_cast<double>(diff));
+                sumLogX += logX;
+                sumLogSlope += logSlope;
+                sumLogXX += logX * logX;
+                sumLogXSlope += logX * logSlope;
+                slopeCount++;
+            }
         }
-        guessContrast(beginIndex, endIndex, 0);
-        guessBrightness((beginIndex + endIndex) / 2, 0, 0);
-    } else {
-        passValuePairsAndSteps(guessGamma);
-        gamma /= numberOfApproximations;
+    }
+    if ((range % stride) != 0) {
+        samples.append({static_cast<double>(endIndex) / size, static_cast<double>(m_gammaTable[endIndex])});
+    }
 
-        passValuePairsAndSteps(guessContrast);
-        contrast /= numberOfApproximations;
+    float gamma = 1.0; // Assume linear gamma if the table is too small
+    const double slopeDenominator = slopeCount * sumLogXX - sumLogX * sumLogX;
+    if (slopeCount >= 2 && slopeDenominator > 0) {
+        gamma = (slopeCount * sumLogXSlope - sumLogX * sumLogSlope) / slopeDenominator + 1.0;
+        if (gamma <= 0) {
+            gamma = 1.0;
+        }
+    }
 
-        passValuePairsAndSteps(guessBrightness);
-        brightness /= numberOfApproximations;
+    double sumU = 0, sumY = 0, sumUU = 0, sumUY = 0;
+    for (const Sample &sample : std::as_const(samples)) {
+        const double u = std::pow(sample.x, static_cast<double>(gamma));
+        sumU += u;
+        sumY += sample.y;
+        sumUU += u * u;
+        sumUY += u * sample.y;
     }
+    const int count = samples.size();
+    const double denominator = count * sumUU - sumU * sumU;
+    const double scale = denominator != 0 ? (count * sumUY - sumU * sumY) / denominator : 0;
+    const double offset = (sumY - scale * sumU) / count;
+
+    const float contrast = scale / m_gammaTableMax;
+    const float brightness = offset / m_gammaTableMax - 0.5 + 0.5 * contrast;
 
     int newGamma = 100.0 / gamma;
     int newContrast = 100.0 - 200.0 / (contrast + 1.0);
@@ -7,6 +7,11 @@
 #ifndef KSANE_GAMMA_OPTION_H
 #define KSANE_GAMMA_OPTION_H
 
+#include <memory>
+
+#include <QPromise>
+#include <QTimer>
+
 #include "baseoption.h"
 
 namespace KSaneCore
@@ -19,25 +24,59 @@ class GammaOption : public BaseOption
 public:
     GammaOption(const SANE_Handle handle, const int index);
 
-    void readValue() override;
+    void applyValueData(const QByteArray &data) override;
 
     QVariant maximumValue() const override;
     QVariant value() const override;
     int valueSize() const override;
     QString valueAsString() const override;
 
+    /* The ranges of brightness, contrast and gamma offered for the software gamma correction */
+    static constexpr int MIN_BRIGHTNESS = -50;
+    static constexpr int MAX_BRIGHTNESS = 50;
+    static constexpr int MIN_CONTRAST = -50;
+    static constexpr int MAX_CONTRAST = 50;
+    static constexpr int MIN_GAMMA = 30;
+    static constexpr int MAX_GAMMA = 300;
+
+    /* Calculates a table with the given size and maximum value like the one written to the device,
+     * the values are clamped to the ranges above */
+    static QVector<int> gammaTable(int brightness, int contrast, int gamma, int size, double maxValue);
+
+    /* Delays writing the table until the value did not change for the given time, 0 writes right away */
+    void setWriteDelay(int msecs);
+
 public Q_SLOTS:
     bool setValue(const QVariant & value) override;
+    void writePendingData();
 
 private:
+    static double gammaCurveValue(double logPosition, int gamma, double maxValue);
+    static void applyBrightnessContrast(const QVector<double> &curve, int brightness, int contrast, double maxValue, QVector<int> &table);
     void calculateGTwriteData();
     void calculateBCGwriteData();
+    void updateGammaCurve(double maxValue);
+    size_t gammaTableHash() const;
+    void scheduleWrite();
 
     int             m_brightness;
     int             m_contrast;
     int             m_gamma;
     QVector<int>    m_gammaTable;
     int             m_gammaTableMax;
+    // hash of the last table read from or written to the device
+    size_t          m_gammaTableHash = 0;
+
+    // gamma curve scaled to the table maximum, brightness and contrast are applied linearly
+    QVector<double> m_gammaCurve;
+    QVector<double> m_logTable;
+    int             m_gammaCurveGamma = -1;
+    double          m_gammaCurveMax = -1;
+
+    // with a delay, rapid changes are written to the device only once they settled
+    int             m_writeDelay = 0;
+    QTimer          m_writeTimer;
+    std::shared_ptr<QPromise<bool>> m_pendingWrite;
 };
 
 }  // namespace KSane
@@ -7,8 +7,6 @@
 
 #include "integeroption.h"
 
-#include <QVarLengthArray>
-
 static const int KSW_INT_MAX = 2147483647;
 static const int KSW_INT_MIN = -2147483647 - 1; // prevent warning
 
@@ -21,22 +19,9 @@ IntegerOption::IntegerOption(const SANE_Handle handle, const int index)
     m_optionType = Option::TypeInteger;
 }
 
-void IntegerOption::readValue()
+void IntegerOption::applyValueData(const QByteArray &data)
 {
-    if (state() == Option::StateHidden) {
-        return;
-    }
-
-    // read that current value
-    QVarLengthArray<unsigned char> data(m_optDesc->size);
-    SANE_Status status;
-    SANE_Int res;
-    status = sane_control_option(m_handle, m_index, SANE_ACTION_GET_VALUE, data.data(), &res);
-    if (status != SANE_STATUS_GOOD) {
-        return;
-    }
-
-    int newValue = toSANE_Word(data.data());
+    int newValue = toSANE_Word(reinterpret_cast<const unsigned char *>(data.constData()));
     if (newValue != m_iVal) {
         m_iVal = newValue;
         Q_EMIT valueChanged(m_iVal);
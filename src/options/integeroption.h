@@ -19,7 +19,7 @@ class IntegerOption : public BaseOption
 public:
     IntegerOption(const SANE_Handle handle, const int index);
 
-    void readValue() override;
+    void applyValueData(const QByteArray &data) override;
 
     QVariant minimumValue() const override;
     QVariant maximumValue() const override;
@@ -7,8 +7,6 @@
 
 #include "listoption.h"
 
-#include <QVarLengthArray>
-
 #include <ksanecore_debug.h>
 
 namespace KSaneCore
@@ -20,31 +18,20 @@ ListOption::ListOption(const SANE_Handle handle, const int index)
     m_optionType = Option::TypeValueList;
 }
 
-void ListOption::readValue()
+void ListOption::applyValueData(const QByteArray &data)
 {
-    if (BaseOption::state() == Option::StateHidden) {
-        return;
-    }
-
-    // read that current value
-    QVarLengthArray<unsigned char> data(m_optDesc->size);
-    SANE_Status status;
-    SANE_Int res;
-    status = sane_control_option(m_handle, m_index, SANE_ACTION_GET_VALUE, data.data(), &res);
-    if (status != SANE_STATUS_GOOD) {
-        return;
-    }
+    const unsigned char *rawData = reinterpret_cast<const unsigned char *>(data.constData());
 
     QVariant newValue;
     switch (m_optDesc->type) {
     case SANE_TYPE_INT:
-        newValue = static_cast<int>(toSANE_Word(data.data()));
+        newValue = static_cast<int>(toSANE_Word(rawData));
         break;
     case SANE_TYPE_FIXED:
-        newValue = SANE_UNFIX(toSANE_Word(data.data()));
+        newValue = SANE_UNFIX(toSANE_Word(rawData));
         break;
     case SANE_TYPE_STRING:
-        newValue = sane_i18n(reinterpret_cast<char *>(data.data()));
+        newValue = sane_i18n(data.constData());
         break;
     default:
         break;
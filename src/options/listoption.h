@@ -19,7 +19,7 @@ class ListOption : public BaseOption
 public:
     ListOption(const SANE_Handle handle, const int index);
 
-    void readValue() override;
+    void applyValueData(const QByteArray &data) override;
     void readOption() override;
 
     QVariant minimumValue() const override;
@@ -0,0 +1,106 @@
+/*
+ * SPDX-FileCopyrightText: 2026 KSaneCore developers
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+ */
+
+#include "softwaregammaoption.h"
+
+#include <ksanecore_debug.h>
+
+#include <algorithm>
+
+#include "gammaoption.h"
+
+namespace KSaneCore
+{
+
+SoftwareGammaOption::SoftwareGammaOption()
+{
+    m_optionType = Option::TypeGamma;
+}
+
+bool SoftwareGammaOption::setValue(const QVariant &newValue)
+{
+    QVariantList values;
+    if (newValue.userType() == QMetaType::QString) {
+        const QStringList stringValues = newValue.toString().split(QLatin1Char(':'));
+        for (const auto &stringValue : stringValues) {
+            bool ok;
+            values.append(stringValue.toInt(&ok));
+            if (!ok) {
+                return false;
+            }
+        }
+    } else if (newValue.canConvert<QVariantList>()) {
+        values = newValue.toList();
+        for (const auto &listValue : std::as_const(values)) {
+            if (listValue.userType() != QMetaType::Int) {
+                return false;
+            }
+        }
+    }
+    if (values.size() != 3) {
+        return false;
+    }
+
+    const int brightness = std::clamp(values.at(0).toInt(), GammaOption::MIN_BRIGHTNESS, GammaOption::MAX_BRIGHTNESS);
+    const int contrast = std::clamp(values.at(1).toInt(), GammaOption::MIN_CONTRAST, GammaOption::MAX_CONTRAST);
+    const int gamma = std::clamp(values.at(2).toInt(), GammaOption::MIN_GAMMA, GammaOption::MAX_GAMMA);
+    if (m_brightness != brightness || m_contrast != contrast || m_gamma != gamma) {
+        m_brightness = brightness;
+        m_contrast = contrast;
+        m_gamma = gamma;
+        Q_EMIT valueChanged(value());
+    }
+    return true;
+}
+
+QVariant SoftwareGammaOption::minimumValue() const
+{
+    return QVariantList{GammaOption::MIN_BRIGHTNESS, GammaOption::MIN_CONTRAST, GammaOption::MIN_GAMMA};
+}
+
+QVariant SoftwareGammaOption::maximumValue() const
+{
+    return QVariantList{GammaOption::MAX_BRIGHTNESS, GammaOption::MAX_CONTRAST, GammaOption::MAX_GAMMA};
+}
+
+QVariant SoftwareGammaOption::value() const
+{
+    return QVariantList{m_brightness, m_contrast, m_gamma};
+}
+
+int SoftwareGammaOption::valueSize() const
+{
+    return 3;
+}
+
+QString SoftwareGammaOption::valueAsString() const
+{
+    return QString::asprintf("%d:%d:%d", m_brightness, m_contrast, m_gamma);
+}
+
+Option::OptionState SoftwareGammaOption::state() const
+{
+    return Option::StateActive;
+}
+
+QString SoftwareGammaOption::name() const
+{
+    return SoftwareGammaOptionName;
+}
+
+QString SoftwareGammaOption::title() const
+{
+    return i18n("Software gamma correction");
+}
+
+QString SoftwareGammaOption::description() const
+{
+    return i18n("Brightness, contrast and gamma applied to the scanned image by the computer.");
+}
+
+} // namespace KSaneCore
+
+#include "moc_softwaregammaoption.cpp"
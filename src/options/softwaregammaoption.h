@@ -0,0 +1,48 @@
+/*
+ * SPDX-FileCopyrightText: 2026 KSaneCore developers
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+ */
+
+#ifndef KSANE_SOFTWARE_GAMMA_OPTION_H
+#define KSANE_SOFTWARE_GAMMA_OPTION_H
+
+#include "baseoption.h"
+
+namespace KSaneCore
+{
+
+static const QString SoftwareGammaOptionName = QStringLiteral("KSane::SoftwareGamma");
+
+/* Brightness, contrast and gamma which are applied to the image data while it is received,
+ * for devices without gamma tables. Values outside of the ranges of GammaOption are clamped. */
+class SoftwareGammaOption : public BaseOption
+{
+    Q_OBJECT
+
+public:
+    SoftwareGammaOption();
+
+    QVariant minimumValue() const override;
+    QVariant maximumValue() const override;
+    QVariant value() const override;
+    int valueSize() const override;
+    QString valueAsString() const override;
+
+    Option::OptionState state() const override;
+    QString name() const override;
+    QString title() const override;
+    QString description() const override;
+
+public Q_SLOTS:
+    bool setValue(const QVariant &value) override;
+
+private:
+    int m_brightness = 0;
+    int m_contrast = 0;
+    int m_gamma = 100;
+};
+
+} // namespace KSaneCore
+
+#endif // KSANE_SOFTWARE_GAMMA_OPTION_H
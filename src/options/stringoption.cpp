@@ -7,8 +7,6 @@
 
 #include "stringoption.h"
 
-#include <QVarLengthArray>
-
 #include <ksanecore_debug.h>
 
 namespace KSaneCore
@@ -35,22 +33,9 @@ bool StringOption::setValue(const QVariant &val)
     return true;
 }
 
-void StringOption::readValue()
+void StringOption::applyValueData(const QByteArray &data)
 {
-    if (state() == Option::StateHidden) {
-        return;
-    }
-
-    // read that current value
-    QVarLengthArray<unsigned char> data(m_optDesc->size);
-    SANE_Status status;
-    SANE_Int res;
-    status = sane_control_option(m_handle, m_index, SANE_ACTION_GET_VALUE, data.data(), &res);
-    if (status != SANE_STATUS_GOOD) {
-        return;
-    }
-
-    m_string = QString::fromUtf8(reinterpret_cast<char *>(data.data()));
+    m_string = QString::fromUtf8(data.constData());
 
     Q_EMIT valueChanged(m_string);
 }
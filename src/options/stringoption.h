@@ -19,7 +19,7 @@ class StringOption : public BaseOption
 public:
     StringOption(const SANE_Handle handle, const int index);
 
-    void readValue() override;
+    void applyValueData(const QByteArray &data) override;
 
     QVariant value() const override;
     int valueSize() const override;
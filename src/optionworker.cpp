@@ -0,0 +1,297 @@
+/*
+ * SPDX-FileCopyrightText: 2026 KSaneCore developers
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+ */
+
+#include "optionworker.h"
+
+#include <QDeadlineTimer>
+#include <QMutexLocker>
+
+#include <ksanecore_debug.h>
+
+// the poll interval of an option grows up to the maximum while its value does not change
+static const int MIN_POLL_INTERVAL = 100;
+static const int MAX_POLL_INTERVAL = 500;
+// after a change the option is polled with the minimum interval for this time
+static const int FAST_POLLING_TIME = 2000;
+// maximum fraction of the time spent waiting for the value of a single polled option
+static const double MAX_POLL_DUTY_CYCLE = 0.1;
+
+namespace KSaneCore
+{
+
+OptionWorker::OptionWorker(SANE_Handle handle)
+    : QThread()
+    , m_saneHandle(handle)
+{
+    m_clock.start();
+}
+
+OptionWorker::~OptionWorker()
+{
+    {
+        QMutexLocker<QMutex> locker(&m_queueMutex);
+        m_shutdown = true;
+        // unfinished promises are canceled when they are destroyed
+        m_requests.clear();
+        m_queueCondition.wakeAll();
+    }
+    wait();
+}
+
+SANE_Status OptionWorker::controlOption(int index, SANE_Action action, void *value, SANE_Int *info)
+{
+    SANE_Status status;
+    {
+        QMutexLocker<QMutex> locker(&m_handleMutex);
+        status = sane_control_option(m_saneHandle, index, action, value, info);
+    }
+    // the value the option has been read with is the one changes are detected against
+    if (action == SANE_ACTION_GET_VALUE && status == SANE_STATUS_GOOD) {
+        updatePolledValue(index, value);
+    }
+    return status;
+}
+
+const SANE_Option_Descriptor *OptionWorker::optionDescriptor(int index)
+{
+    QMutexLocker<QMutex> locker(&m_handleMutex);
+    return sane_get_option_descriptor(m_saneHandle, index);
+}
+
+void OptionWorker::cancelScan()
+{
+    QMutexLocker<QMutex> locker(&m_handleMutex);
+    sane_cancel(m_saneHandle);
+}
+
+void OptionWorker::setAsynchronous(bool asynchronous)
+{
+    m_asynchronous = asynchronous;
+}
+
+bool OptionWorker::isAsynchronous() const
+{
+    return m_asynchronous;
+}
+
+void OptionWorker::queueRead(int index, int size, int serial)
+{
+    QMutexLocker<QMutex> locker(&m_queueMutex);
+    // a pending read of the same option returns the same value
+    for (const auto &request : m_requests) {
+        if (request.type == ReadValue && request.index == index && request.serial == serial) {
+            return;
+        }
+    }
+    enqueue({ReadValue, index, serial, QByteArray(size, 0), {}});
+}
+
+void OptionWorker::queueStore(int index, int size)
+{
+    QMutexLocker<QMutex> locker(&m_queueMutex);
+    enqueue({StoreValue, index, 0, QByteArray(size, 0), {}});
+}
+
+QFuture<bool> OptionWorker::queueWrite(int index, const QByteArray &data)
+{
+    QPromise<bool> promise;
+    QFuture<bool> future = promise.future();
+    promise.start();
+
+    QMutexLocker<QMutex> locker(&m_queueMutex);
+    // coalesce with a pending write of the same option, unless a read or store of the option
+    // is queued in between, which has to see the value of the earlier write
+    for (auto it = m_requests.rbegin(); it != m_requests.rend(); ++it) {
+        if (it->type == WriteValue && it->index == index) {
+            it->data = data;
+            it->promises.push_back(std::move(promise));
+            return future;
+        }
+        if (it->type == WriteValue || it->index == index) {
+            break;
+        }
+    }
+
+    Request request{WriteValue, index, 0, data, {}};
+    request.promises.push_back(std::move(promise));
+    enqueue(std::move(request));
+    return future;
+}
+
+void OptionWorker::enqueue(Request &&request)
+{
+    m_requests.push_back(std::move(request));
+    if (!isRunning()) {
+        start();
+    }
+    m_queueCondition.wakeOne();
+}
+
+bool OptionWorker::isIdle() const
+{
+    QMutexLocker<QMutex> locker(&m_queueMutex);
+    return !m_busy && m_requests.empty();
+}
+
+void OptionWorker::addPollOption(int index, int size)
+{
+    QMutexLocker<QMutex> locker(&m_queueMutex);
+    m_pollOptions.append({index, size, QByteArray(), MIN_POLL_INTERVAL, 0, 0, 0});
+}
+
+void OptionWorker::updatePolledValue(int index, const void *value)
+{
+    QMutexLocker<QMutex> locker(&m_queueMutex);
+    for (auto &option : m_pollOptions) {
+        if (option.index == index) {
+            option.data = QByteArray(static_cast<const char *>(value), option.size);
+        }
+    }
+}
+
+void OptionWorker::setPollingEnabled(bool enabled)
+{
+    QMutexLocker<QMutex> locker(&m_queueMutex);
+    m_pollingEnabled = enabled;
+    if (enabled && !m_pollOptions.isEmpty()) {
+        if (!isRunning()) {
+            start();
+        }
+        m_queueCondition.wakeOne();
+    }
+}
+
+OptionWorker::PollOption *OptionWorker::nextPollOption()
+{
+    PollOption *next = nullptr;
+    for (auto &option : m_pollOptions) {
+        if (next == nullptr || option.nextPoll < next->nextPoll) {
+            next = &option;
+        }
+    }
+    return next;
+}
+
+void OptionWorker::pollOption(PollOption &option)
+{
+    QByteArray data(option.size, 0);
+    SANE_Int info;
+
+    // not through controlOption(), which would replace the value the new one is compared with
+    const qint64 start = m_clock.elapsed();
+    SANE_Status status;
+    {
+        QMutexLocker<QMutex> locker(&m_handleMutex);
+        status = sane_control_option(m_saneHandle, option.index, SANE_ACTION_GET_VALUE, data.data(), &info);
+    }
+    const qint64 now = m_clock.elapsed();
+
+    if (status == SANE_STATUS_GOOD && option.data.isEmpty()) {
+        // the first value is the one the option has been loaded with
+        option.data = data;
+    } else if (status == SANE_STATUS_GOOD && data != option.data) {
+        option.data = data;
+        option.interval = MIN_POLL_INTERVAL;
+        option.fastPollingEnd = now + FAST_POLLING_TIME;
+        Q_EMIT polledValueChanged(option.index, data);
+    } else if (now >= option.fastPollingEnd) {
+        // back off exponentially while the value does not change or can not be read
+        option.interval = qMin(option.interval * 2, MAX_POLL_INTERVAL);
+    }
+    if (status != SANE_STATUS_GOOD) {
+        qCDebug(KSANECORE_LOG) << "polling option" << option.index << "failed:" << sane_strstatus(status);
+    }
+
+    // a slow option is polled less often, so that it spends a limited share of the time
+    // blocking the device, the other options keep their interval
+    option.readTime = (option.readTime + (now - start)) / 2;
+    const qint64 readPause = static_cast<qint64>(option.readTime * (1.0 - MAX_POLL_DUTY_CYCLE) / MAX_POLL_DUTY_CYCLE);
+    option.nextPoll = now + qMax<qint64>(option.interval, readPause);
+}
+
+void OptionWorker::run()
+{
+    QMutexLocker<QMutex> locker(&m_queueMutex);
+    while (!m_shutdown) {
+        if (m_requests.empty()) {
+            PollOption *next = m_pollingEnabled ? nextPollOption() : nullptr;
+            if (next == nullptr) {
+                m_queueCondition.wait(&m_queueMutex);
+                continue;
+            }
+            const qint64 now = m_clock.elapsed();
+            if (next->nextPoll > now) {
+                m_queueCondition.wait(&m_queueMutex, QDeadlineTimer(next->nextPoll - now));
+                continue;
+            }
+
+            m_busy = true;
+            PollOption polled = *next;
+            locker.unlock();
+            pollOption(polled);
+            locker.relock();
+            m_busy = false;
+
+            for (auto &option : m_pollOptions) {
+                if (option.index == polled.index) {
+                    option = polled;
+                }
+            }
+            // somebody might wait for the worker to finish polling
+            if (!m_pollingEnabled && m_requests.empty()) {
+                Q_EMIT idle();
+            }
+            continue;
+        }
+
+        Request request = std::move(m_requests.front());
+        m_requests.pop_front();
+        m_busy = true;
+        locker.unlock();
+
+        executeRequest(request);
+
+        locker.relock();
+        m_busy = false;
+        if (m_requests.empty()) {
+            Q_EMIT idle();
+        }
+    }
+}
+
+void OptionWorker::executeRequest(Request &request)
+{
+    SANE_Int info = 0;
+    SANE_Status status;
+
+    switch (request.type) {
+    case ReadValue:
+    case StoreValue:
+        status = controlOption(request.index, SANE_ACTION_GET_VALUE, request.data.data(), &info);
+        if (status != SANE_STATUS_GOOD) {
+            qCDebug(KSANECORE_LOG) << "reading option" << request.index << "failed:" << sane_strstatus(status);
+            return;
+        }
+        if (request.type == ReadValue) {
+            Q_EMIT valueRead(request.index, request.data, request.serial);
+        } else {
+            Q_EMIT valueStored(request.index, request.data);
+        }
+        return;
+    case WriteValue:
+        status = controlOption(request.index, SANE_ACTION_SET_VALUE, request.data.data(), &info);
+        Q_EMIT valueWritten(request.index, status, info);
+        for (auto &promise : request.promises) {
+            promise.addResult(status == SANE_STATUS_GOOD);
+            promise.finish();
+        }
+        return;
+    }
+}
+
+} // namespace KSaneCore
+
+#include "moc_optionworker.cpp"
@@ -0,0 +1,123 @@
+/*
+ * SPDX-FileCopyrightText: 2026 KSaneCore developers
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+ */
+
+#ifndef KSANE_OPTION_WORKER_H
+#define KSANE_OPTION_WORKER_H
+
+// Sane includes
+extern "C"
+{
+#include <sane/saneopts.h>
+#include <sane/sane.h>
+}
+
+#include <deque>
+#include <vector>
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QFuture>
+#include <QMutex>
+#include <QPromise>
+#include <QThread>
+#include <QWaitCondition>
+
+namespace KSaneCore
+{
+
+/* Serializes all sane_control_option calls for one device handle.
+ * Calls can either be executed directly on the calling thread with
+ * controlOption() or be queued to run on the worker thread. Queued
+ * requests are executed in order, a write replaces a still pending
+ * write of the same option as long as no other option is written and
+ * the option is not read in between.
+ * When idle, the worker polls the read-only options like sensors and buttons.
+ * The poll interval of an option adapts to how often its value changes and to
+ * how long reading it takes, so slow options are polled less often instead of
+ * blocking the device, while the others keep their interval. */
+class OptionWorker : public QThread
+{
+    Q_OBJECT
+
+public:
+    explicit OptionWorker(SANE_Handle handle);
+    ~OptionWorker() override;
+
+    SANE_Status controlOption(int index, SANE_Action action, void *value, SANE_Int *info);
+    const SANE_Option_Descriptor *optionDescriptor(int index);
+    void cancelScan();
+
+    void setAsynchronous(bool asynchronous);
+    bool isAsynchronous() const;
+
+    void queueRead(int index, int size, int serial);
+    void queueStore(int index, int size);
+    QFuture<bool> queueWrite(int index, const QByteArray &data);
+    bool isIdle() const;
+
+    void addPollOption(int index, int size);
+    void setPollingEnabled(bool enabled);
+
+    void run() override;
+
+Q_SIGNALS:
+    void valueRead(int index, const QByteArray &data, int serial);
+    void valueStored(int index, const QByteArray &data);
+    void valueWritten(int index, int status, int info);
+    void polledValueChanged(int index, const QByteArray &data);
+    void idle();
+
+private:
+    enum RequestType {
+        ReadValue,
+        StoreValue,
+        WriteValue,
+    };
+
+    struct Request {
+        RequestType type;
+        int index;
+        int serial;
+        QByteArray data;
+        std::vector<QPromise<bool>> promises;
+    };
+
+    struct PollOption {
+        int index;
+        int size;
+        // the last value read, empty until the option has been read once
+        QByteArray data;
+        int interval;
+        qint64 nextPoll;
+        qint64 fastPollingEnd;
+        // the measured time it takes to read the value
+        qint64 readTime;
+    };
+
+    void enqueue(Request &&request);
+    void executeRequest(Request &request);
+    PollOption *nextPollOption();
+    void pollOption(PollOption &option);
+    void updatePolledValue(int index, const void *value);
+
+    SANE_Handle m_saneHandle;
+    QMutex m_handleMutex;
+    bool m_asynchronous = false;
+
+    mutable QMutex m_queueMutex;
+    QWaitCondition m_queueCondition;
+    std::deque<Request> m_requests;
+    bool m_busy = false;
+    bool m_shutdown = false;
+
+    QList<PollOption> m_pollOptions;
+    bool m_pollingEnabled = false;
+    QElapsedTimer m_clock;
+};
+
+} // namespace KSaneCore
+
+#endif // KSANE_OPTION_WORKER_H
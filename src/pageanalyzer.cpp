@@ -0,0 +1,581 @@
+/*
+ * SPDX-FileCopyrightText: 2026 KSaneCore developers
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+ */
+
+#include "pageanalyzer.h"
+
+#include <QImage>
+#include <QtMath>
+
+// pixels darker than this fraction of the maximum value are counted as ink
+static const double INK_LEVEL = 0.5;
+// the standard deviation of the brightness of a blank page is below this fraction of the maximum value
+static const double BLANK_MAXIMUM_DEVIATION = 0.1;
+// pixels whose channels differ by more than this fraction of the maximum value are colored
+static const double COLOR_CHROMA_LEVEL = 0.1;
+// a page with more colored pixels than this share is a color page
+static const double COLOR_MINIMUM_RATIO = 0.001;
+// pixels between these fractions of the maximum value are neither black nor white
+static const double MIDTONE_LOW_LEVEL = 0.25;
+static const double MIDTONE_HIGH_LEVEL = 0.75;
+// a page with fewer midtone pixels than this share, e.g. from anti-aliased text, is a lineart page
+static const double LINEART_MAXIMUM_MIDTONE_RATIO = 0.05;
+// pixels darker than this fraction of the maximum value do not belong to the background
+static const double CONTENT_LEVEL = 0.9;
+// rows with fewer content pixels, e.g. dust, do not extend the content area
+static const int CONTENT_MINIMUM_PIXELS = 3;
+// the skew is estimated in steps up to the maximum angle in degrees
+static const double SKEW_MAXIMUM_ANGLE = 5.0;
+static const double SKEW_ANGLE_STEP = 0.25;
+static const int SKEW_ANGLES = 41;
+// only every nth column is sampled for the skew estimation
+static const int SKEW_SAMPLE_STEP = 4;
+// fewer dark samples do not allow a reliable estimation
+static const int SKEW_MINIMUM_SAMPLES = 1000;
+// the perceptual hash has one bit for each cell of a grid of this size
+static const int HASH_GRID_SIZE = 8;
+// consecutive pixels are counted in separate histograms, so that equal values do not
+// wait for each other's increment, they are merged when the page is complete
+static const int SUB_HISTOGRAMS = 4;
+
+namespace KSaneCore
+{
+
+PageAnalyzer::PageAnalyzer()
+    : m_maximumInkRatio(0.005)
+    , m_marginPercent(5)
+    , m_sha256(QCryptographicHash::Sha256)
+{
+}
+
+void PageAnalyzer::setBlankPageDetection(double maximumInkRatio, int marginPercent)
+{
+    m_maximumInkRatio = qMax(maximumInkRatio, 0.0);
+    m_marginPercent = qBound(0, marginPercent, 49);
+}
+
+void PageAnalyzer::setHashing(bool enable)
+{
+    m_hashing = enable;
+}
+
+void PageAnalyzer::setAnalyses(Analyses analyses)
+{
+    m_analyses = analyses;
+}
+
+void PageAnalyzer::start(const QImage &image, int lines)
+{
+    m_width = image.width();
+    // handscanners do not know the number of lines in advance
+    m_lines = lines;
+    m_maxValue = image.depth() == 16 || image.depth() == 64 ? 0xFFFF : 0xFF;
+    m_channels = image.format() == QImage::Format_RGB32 || image.format() == QImage::Format_RGBX64 ? 3 : 1;
+    for (int i = 0; i < m_channels; i++) {
+        m_row[i].resize(m_width);
+    }
+    m_luminance.resize(m_width);
+
+    m_marginX = m_width * m_marginPercent / 100;
+    m_marginY = qMax(m_lines, 0) * m_marginPercent / 100;
+    m_inkPixels = 0;
+    m_pixelCount = 0;
+    m_luminanceSum = 0;
+    m_luminanceSquareSum = 0;
+    m_blankPage = false;
+
+    for (int i = 0; i < 3; i++) {
+        m_subHistograms[i].clear();
+        m_histograms[i].clear();
+    }
+    if (m_analyses & HistogramAnalysis) {
+        for (int i = 0; i < m_channels; i++) {
+            m_subHistograms[i].fill(0, (m_maxValue + 1) * SUB_HISTOGRAMS);
+        }
+    }
+    m_minimum.fill(m_maxValue);
+    m_maximum.fill(0);
+    m_sum.fill(0);
+    m_histogramPixels = 0;
+
+    m_colorPixels = 0;
+    m_midtonePixels = 0;
+    m_classifiedPixels = 0;
+    m_pageType = m_channels == 3 ? ColorPage : GrayPage;
+
+    m_contentLeft = m_width;
+    m_contentRight = -1;
+    m_contentTop = -1;
+    m_contentBottom = -1;
+
+    m_skewOffsets.clear();
+    m_skewProfiles.clear();
+    m_skewDarkSamples = 0;
+    m_skewAngle = 0;
+    if (m_analyses & SkewAnalysis) {
+        // the offsets are shifted by the largest one, so that all indexes are positive
+        m_skewSamples = (m_width + SKEW_SAMPLE_STEP - 1) / SKEW_SAMPLE_STEP;
+        m_skewMaxOffset = qCeil(m_width * qTan(qDegreesToRadians(SKEW_MAXIMUM_ANGLE)));
+        m_skewOffsets.resize(SKEW_ANGLES * m_skewSamples);
+        for (int angle = 0; angle < SKEW_ANGLES; angle++) {
+            const double slope = qTan(qDegreesToRadians(-SKEW_MAXIMUM_ANGLE + angle * SKEW_ANGLE_STEP));
+            for (int sample = 0; sample < m_skewSamples; sample++) {
+                m_skewOffsets[sample * SKEW_ANGLES + angle] = m_skewMaxOffset - qRound(sample * SKEW_SAMPLE_STEP * slope);
+            }
+        }
+        // the profiles of handscanner images grow with the received rows
+        m_skewProfiles.fill(0, (qMax(m_lines, 0) + 2 * m_skewMaxOffset + 1) * SKEW_ANGLES);
+    }
+
+    m_sha256.reset();
+    m_digest.clear();
+    m_hashCells.fill(0);
+    m_hashRowCells.clear();
+    m_hashedRows = 0;
+    m_perceptualHash = 0;
+}
+
+void PageAnalyzer::analyzeRows(const QImage &image, int firstRow, int endRow)
+{
+    if (m_analyses == NoAnalysis && !m_hashing) {
+        return;
+    }
+    for (int y = firstRow; y < endRow; y++) {
+        readRow(image, y);
+        if (m_analyses & BlankPageAnalysis) {
+            analyzeBlankPage(y);
+        }
+        if (m_analyses & HistogramAnalysis) {
+            analyzeHistograms();
+        }
+        if (m_analyses & PageTypeAnalysis) {
+            analyzeColors();
+        }
+        if (m_analyses & ContentAnalysis) {
+            analyzeContent(y);
+        }
+        if (m_analyses & SkewAnalysis) {
+            analyzeSkew(y);
+        }
+        analyzeHashes(image, y);
+    }
+}
+
+void PageAnalyzer::finish()
+{
+    finishHashes();
+    finishSkew();
+
+    if (m_pixelCount > 0) {
+        const double mean = m_luminanceSum / m_pixelCount;
+        const double deviation = qSqrt(qMax(m_luminanceSquareSum / m_pixelCount - mean * mean, 0.0));
+        m_blankPage = static_cast<double>(m_inkPixels) / m_pixelCount <= m_maximumInkRatio && deviation <= m_maxValue * BLANK_MAXIMUM_DEVIATION;
+    }
+
+    if (m_classifiedPixels > 0) {
+        if (static_cast<double>(m_colorPixels) / m_classifiedPixels > COLOR_MINIMUM_RATIO) {
+            m_pageType = ColorPage;
+        } else if (static_cast<double>(m_midtonePixels) / m_classifiedPixels < LINEART_MAXIMUM_MIDTONE_RATIO) {
+            m_pageType = LineartPage;
+        } else {
+            m_pageType = GrayPage;
+        }
+    }
+
+    if (!(m_analyses & HistogramAnalysis)) {
+        return;
+    }
+    const int bins = m_maxValue + 1;
+    for (int i = 0; i < m_channels; i++) {
+        const quint32 *subHistograms = m_subHistograms[i].constData();
+        m_histograms[i].resize(bins);
+        qint64 *histogram = m_histograms[i].data();
+        for (int bin = 0; bin < bins; bin++) {
+            qint64 count = 0;
+            for (int sub = 0; sub < SUB_HISTOGRAMS; sub++) {
+                count += subHistograms[sub * bins + bin];
+            }
+            histogram[bin] = count;
+        }
+    }
+}
+
+bool PageAnalyzer::isBlankPage() const
+{
+    return m_blankPage;
+}
+
+PageAnalyzer::PageType PageAnalyzer::pageType() const
+{
+    return m_pageType;
+}
+
+quint64 PageAnalyzer::perceptualHash() const
+{
+    return m_perceptualHash;
+}
+
+double PageAnalyzer::skewAngle() const
+{
+    return m_skewAngle;
+}
+
+QRect PageAnalyzer::contentArea() const
+{
+    if (m_contentTop < 0) {
+        return QRect();
+    }
+    return QRect(QPoint(m_contentLeft, m_contentTop), QPoint(m_contentRight, m_contentBottom));
+}
+
+QVariantMap PageAnalyzer::metadata() const
+{
+    QVariantMap metadata;
+    if (m_analyses & BlankPageAnalysis) {
+        metadata[QStringLiteral("blankPage")] = m_blankPage;
+        metadata[QStringLiteral("inkRatio")] = m_pixelCount > 0 ? static_cast<double>(m_inkPixels) / m_pixelCount : 0.0;
+    }
+
+    if (m_analyses & PageTypeAnalysis) {
+        switch (m_pageType) {
+        case ColorPage:
+            metadata[QStringLiteral("pageType")] = QStringLiteral("color");
+            break;
+        case GrayPage:
+            metadata[QStringLiteral("pageType")] = QStringLiteral("gray");
+            break;
+        case LineartPage:
+            metadata[QStringLiteral("pageType")] = QStringLiteral("lineart");
+            break;
+        }
+    }
+
+    if (m_analyses & ContentAnalysis) {
+        metadata[QStringLiteral("contentArea")] = contentArea();
+    }
+    if (m_analyses & SkewAnalysis) {
+        metadata[QStringLiteral("skewAngle")] = m_skewAngle;
+    }
+    if (m_hashing) {
+        metadata[QStringLiteral("sha256")] = QString::fromLatin1(m_digest.toHex());
+        // a page without rows has no perceptual hash, it would be similar to any other one
+        if (m_hashedRows > 0) {
+            metadata[QStringLiteral("perceptualHash")] = m_perceptualHash;
+        }
+    }
+
+    if (!(m_analyses & HistogramAnalysis)) {
+        return metadata;
+    }
+    QList<QList<qint64>> histograms;
+    QList<int> minimum;
+    QList<int> maximum;
+    QList<double> mean;
+    for (int i = 0; i < m_channels; i++) {
+        histograms.append(m_histograms[i]);
+        minimum.append(m_minimum[i]);
+        maximum.append(m_maximum[i]);
+        mean.append(m_histogramPixels > 0 ? static_cast<double>(m_sum[i]) / m_histogramPixels : 0.0);
+    }
+    metadata[QStringLiteral("histograms")] = QVariant::fromValue(histograms);
+    metadata[QStringLiteral("minimum")] = QVariant::fromValue(minimum);
+    metadata[QStringLiteral("maximum")] = QVariant::fromValue(maximum);
+    metadata[QStringLiteral("mean")] = QVariant::fromValue(mean);
+    return metadata;
+}
+
+void PageAnalyzer::readRow(const QImage &image, int y)
+{
+    const uchar *line = image.constScanLine(y);
+    int *row0 = m_row[0].data();
+
+    switch (image.format()) {
+    case QImage::Format_Mono:
+        // a set bit is black
+        for (int x = 0; x < m_width; x++) {
+            row0[x] = (line[x >> 3] >> (7 - (x & 7))) & 1 ? 0 : 0xFF;
+        }
+        break;
+    case QImage::Format_Grayscale8:
+        for (int x = 0; x < m_width; x++) {
+            row0[x] = line[x];
+        }
+        break;
+    case QImage::Format_Grayscale16: {
+        const quint16 *pixels = reinterpret_cast<const quint16 *>(line);
+        for (int x = 0; x < m_width; x++) {
+            row0[x] = pixels[x];
+        }
+        break;
+    }
+    case QImage::Format_RGBX64: {
+        const QRgba64 *pixels = reinterpret_cast<const QRgba64 *>(line);
+        int *row1 = m_row[1].data();
+        int *row2 = m_row[2].data();
+        for (int x = 0; x < m_width; x++) {
+            row0[x] = pixels[x].red();
+            row1[x] = pixels[x].green();
+            row2[x] = pixels[x].blue();
+        }
+        break;
+    }
+    default: {
+        const QRgb *pixels = reinterpret_cast<const QRgb *>(line);
+        int *row1 = m_row[1].data();
+        int *row2 = m_row[2].data();
+        for (int x = 0; x < m_width; x++) {
+            row0[x] = qRed(pixels[x]);
+            row1[x] = qGreen(pixels[x]);
+            row2[x] = qBlue(pixels[x]);
+        }
+        break;
+    }
+    }
+
+    int *luminance = m_luminance.data();
+    if (m_channels == 1) {
+        for (int x = 0; x < m_width; x++) {
+            luminance[x] = row0[x];
+        }
+    } else {
+        const int *row1 = m_row[1].constData();
+        const int *row2 = m_row[2].constData();
+        for (int x = 0; x < m_width; x++) {
+            // same weights as qGray()
+            luminance[x] = (row0[x] * 11 + row1[x] * 16 + row2[x] * 5) / 32;
+        }
+    }
+}
+
+void PageAnalyzer::analyzeBlankPage(int y)
+{
+    if (y < m_marginY || (m_lines > 0 && y >= m_lines - m_marginY)) {
+        return;
+    }
+
+    const int inkLevel = static_cast<int>(m_maxValue * INK_LEVEL);
+    const int *luminance = m_luminance.constData();
+    qint64 inkPixels = 0;
+    double luminanceSum = 0;
+    double luminanceSquareSum = 0;
+    for (int x = m_marginX; x < m_width - m_marginX; x++) {
+        if (luminance[x] < inkLevel) {
+            inkPixels++;
+        }
+        luminanceSum += luminance[x];
+        luminanceSquareSum += static_cast<double>(luminance[x]) * luminance[x];
+    }
+    m_inkPixels += inkPixels;
+    m_pixelCount += qMax(m_width - 2 * m_marginX, 0);
+    m_luminanceSum += luminanceSum;
+    m_luminanceSquareSum += luminanceSquareSum;
+}
+
+void PageAnalyzer::analyzeHistograms()
+{
+    const int bins = m_maxValue + 1;
+    for (int i = 0; i < m_channels; i++) {
+        const int *row = m_row[i].constData();
+        quint32 *subHistograms = m_subHistograms[i].data();
+        int minimum = m_minimum[i];
+        int maximum = m_maximum[i];
+        qint64 sum = 0;
+
+        int x = 0;
+        for (; x + SUB_HISTOGRAMS <= m_width; x += SUB_HISTOGRAMS) {
+            for (int sub = 0; sub < SUB_HISTOGRAMS; sub++) {
+                const int value = row[x + sub];
+                subHistograms[sub * bins + value]++;
+                minimum = qMin(minimum, value);
+                maximum = qMax(maximum, value);
+                sum += value;
+            }
+        }
+        for (; x < m_width; x++) {
+            const int value = row[x];
+            subHistograms[value]++;
+            minimum = qMin(minimum, value);
+            maximum = qMax(maximum, value);
+            sum += value;
+        }
+
+        m_minimum[i] = minimum;
+        m_maximum[i] = maximum;
+        m_sum[i] += sum;
+    }
+    m_histogramPixels += m_width;
+}
+
+void PageAnalyzer::analyzeColors()
+{
+    const int chromaLevel = static_cast<int>(m_maxValue * COLOR_CHROMA_LEVEL);
+    const int midtoneLow = static_cast<int>(m_maxValue * MIDTONE_LOW_LEVEL);
+    const int midtoneHigh = static_cast<int>(m_maxValue * MIDTONE_HIGH_LEVEL);
+    const int *luminance = m_luminance.constData();
+    qint64 colorPixels = 0;
+    qint64 midtonePixels = 0;
+
+    for (int x = 0; x < m_width; x++) {
+        midtonePixels += luminance[x] > midtoneLow && luminance[x] < midtoneHigh;
+    }
+    if (m_channels == 3) {
+        const int *row0 = m_row[0].constData();
+        const int *row1 = m_row[1].constData();
+        const int *row2 = m_row[2].constData();
+        for (int x = 0; x < m_width; x++) {
+            const int chroma = qMax(row0[x], qMax(row1[x], row2[x])) - qMin(row0[x], qMin(row1[x], row2[x]));
+            colorPixels += chroma > chromaLevel;
+        }
+    }
+    m_colorPixels += colorPixels;
+    m_midtonePixels += midtonePixels;
+    m_classifiedPixels += m_width;
+}
+
+void PageAnalyzer::analyzeContent(int y)
+{
+    const int contentLevel = static_cast<int>(m_maxValue * CONTENT_LEVEL);
+    const int *luminance = m_luminance.constData();
+    int contentPixels = 0;
+    int left = m_width;
+    int right = -1;
+    for (int x = 0; x < m_width; x++) {
+        if (luminance[x] < contentLevel) {
+            contentPixels++;
+            left = qMin(left, x);
+            right = x;
+        }
+    }
+    if (contentPixels < CONTENT_MINIMUM_PIXELS) {
+        return;
+    }
+
+    m_contentLeft = qMin(m_contentLeft, left);
+    m_contentRight = qMax(m_contentRight, right);
+    if (m_contentTop < 0) {
+        m_contentTop = y;
+    }
+    m_contentBottom = y;
+}
+
+void PageAnalyzer::analyzeSkew(int y)
+{
+    const int profileSize = (y + 2 * m_skewMaxOffset + 1) * SKEW_ANGLES;
+    if (m_skewProfiles.size() < profileSize) {
+        // the new elements are zero
+        m_skewProfiles.resize(qMax<qsizetype>(profileSize, m_skewProfiles.size() * 2));
+    }
+
+    // the profiles of all angles of a row are next to each other, a dark sample adds to each of them
+    const int inkLevel = static_cast<int>(m_maxValue * INK_LEVEL);
+    const int *luminance = m_luminance.constData();
+    const int *offsets = m_skewOffsets.constData();
+    int *profiles = m_skewProfiles.data() + y * SKEW_ANGLES;
+    for (int sample = 0; sample < m_skewSamples; sample++) {
+        if (luminance[sample * SKEW_SAMPLE_STEP] >= inkLevel) {
+            continue;
+        }
+        m_skewDarkSamples++;
+        const int *sampleOffsets = offsets + sample * SKEW_ANGLES;
+        for (int angle = 0; angle < SKEW_ANGLES; angle++) {
+            profiles[sampleOffsets[angle] * SKEW_ANGLES + angle]++;
+        }
+    }
+}
+
+void PageAnalyzer::finishSkew()
+{
+    if (!(m_analyses & SkewAnalysis) || m_skewDarkSamples < SKEW_MINIMUM_SAMPLES) {
+        return;
+    }
+
+    // the number of samples is the same for all angles, the sum of squares grows with the peaks
+    std::array<double, SKEW_ANGLES> scores;
+    scores.fill(0);
+    const int *profiles = m_skewProfiles.constData();
+    for (qsizetype i = 0; i < m_skewProfiles.size(); i += SKEW_ANGLES) {
+        for (int angle = 0; angle < SKEW_ANGLES; angle++) {
+            scores[angle] += static_cast<double>(profiles[i + angle]) * profiles[i + angle];
+        }
+    }
+    double bestScore = -1;
+    for (int angle = 0; angle < SKEW_ANGLES; angle++) {
+        if (scores[angle] > bestScore) {
+            bestScore = scores[angle];
+            m_skewAngle = -SKEW_MAXIMUM_ANGLE + angle * SKEW_ANGLE_STEP;
+        }
+    }
+}
+
+void PageAnalyzer::analyzeHashes(const QImage &image, int y)
+{
+    if (!m_hashing) {
+        return;
+    }
+    // without the padding at the end of the row
+    const int rowBytes = (m_width * image.depth() + 7) / 8;
+    m_sha256.addData(QByteArrayView(image.constScanLine(y), rowBytes));
+
+    if (m_lines > 0 && y >= m_lines) {
+        return;
+    }
+    m_hashedRows++;
+    const int *luminance = m_luminance.constData();
+    std::array<double, HASH_GRID_SIZE> rowCells;
+    for (int cell = 0; cell < HASH_GRID_SIZE; cell++) {
+        const int firstColumn = cell * m_width / HASH_GRID_SIZE;
+        const int endColumn = (cell + 1) * m_width / HASH_GRID_SIZE;
+        qint64 sum = 0;
+        for (int x = firstColumn; x < endColumn; x++) {
+            sum += luminance[x];
+        }
+        rowCells[cell] = sum;
+    }
+
+    // the rows of handscanner images are assigned to the cells of the grid at the end
+    if (m_lines <= 0) {
+        for (const double cell : rowCells) {
+            m_hashRowCells.append(cell);
+        }
+        return;
+    }
+    double *cells = m_hashCells.data() + (y * HASH_GRID_SIZE / m_lines) * HASH_GRID_SIZE;
+    for (int cell = 0; cell < HASH_GRID_SIZE; cell++) {
+        cells[cell] += rowCells[cell];
+    }
+}
+
+void PageAnalyzer::finishHashes()
+{
+    if (!m_hashing) {
+        return;
+    }
+    m_digest = m_sha256.result();
+    if (m_hashedRows == 0) {
+        return;
+    }
+    // now the height of handscanner images is known
+    const int rows = m_hashRowCells.size() / HASH_GRID_SIZE;
+    for (int y = 0; y < rows; y++) {
+        double *cells = m_hashCells.data() + (y * HASH_GRID_SIZE / rows) * HASH_GRID_SIZE;
+        for (int cell = 0; cell < HASH_GRID_SIZE; cell++) {
+            cells[cell] += m_hashRowCells.at(y * HASH_GRID_SIZE + cell);
+        }
+    }
+
+    // the cells have almost the same size, their sums are compared instead of their averages
+    double mean = 0;
+    for (const double cell : m_hashCells) {
+        mean += cell / m_hashCells.size();
+    }
+    m_perceptualHash = 0;
+    for (size_t i = 0; i < m_hashCells.size(); i++) {
+        if (m_hashCells[i] > mean) {
+            m_perceptualHash |= Q_UINT64_C(1) << i;
+        }
+    }
+}
+
+} // namespace KSaneCore
@@ -0,0 +1,150 @@
+/*
+ * SPDX-FileCopyrightText: 2026 KSaneCore developers
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+ */
+
+#ifndef KSANE_PAGE_ANALYZER_H
+#define KSANE_PAGE_ANALYZER_H
+
+#include <array>
+
+#include <QByteArray>
+#include <QCryptographicHash>
+#include <QFlags>
+#include <QRect>
+#include <QVariantMap>
+#include <QVector>
+
+class QImage;
+
+namespace KSaneCore
+{
+
+/* Gathers information about a page while the ImageBuilder writes its rows,
+ * so that no additional pass over the finished image is needed.
+ * The rows are analyzed as soon as they are complete, while they are still in the cache. */
+class PageAnalyzer
+{
+public:
+    enum PageType {
+        ColorPage,
+        GrayPage,
+        LineartPage,
+    };
+
+    /* The analyses done for every row, the results of the others keep their defaults.
+     * The skew estimation is the most expensive one, it is not part of AllAnalyses. */
+    enum Analysis {
+        NoAnalysis = 0,
+        BlankPageAnalysis = 1,
+        HistogramAnalysis = 2,
+        PageTypeAnalysis = 4,
+        ContentAnalysis = 8,
+        SkewAnalysis = 16,
+        AllAnalyses = BlankPageAnalysis | HistogramAnalysis | PageTypeAnalysis | ContentAnalysis,
+    };
+    Q_DECLARE_FLAGS(Analyses, Analysis)
+
+    PageAnalyzer();
+
+    /* A page is blank if at most the given ratio of its pixels is dark and its brightness hardly varies.
+     * The margins are given in percent of the page size and are ignored. */
+    void setBlankPageDetection(double maximumInkRatio, int marginPercent);
+    /* Enables the SHA-256 hash of the image data and the perceptual hash of the page */
+    void setHashing(bool enable);
+    /* Only the results of the enabled analyses are part of the metadata */
+    void setAnalyses(Analyses analyses);
+
+    void start(const QImage &image, int lines);
+    void analyzeRows(const QImage &image, int firstRow, int endRow);
+    void finish();
+
+    bool isBlankPage() const;
+    PageType pageType() const;
+    /* The area of the page which differs from the white background, null for an empty page */
+    QRect contentArea() const;
+    /* Similar pages have perceptual hashes which differ in only a few bits, it is only part of
+     * the metadata if rows have been analyzed */
+    quint64 perceptualHash() const;
+    /* The angle in degrees the lines of the page are rotated clockwise, 0 if it could not be estimated */
+    double skewAngle() const;
+    QVariantMap metadata() const;
+
+private:
+    void readRow(const QImage &image, int y);
+    void analyzeBlankPage(int y);
+    void analyzeHistograms();
+    void analyzeColors();
+    void analyzeContent(int y);
+    void analyzeSkew(int y);
+    void finishSkew();
+    void analyzeHashes(const QImage &image, int y);
+    void finishHashes();
+
+    // the pixel values of the current row, gray images only use the first channel
+    std::array<QVector<int>, 3> m_row;
+    QVector<int> m_luminance;
+    int m_channels = 1;
+    int m_maxValue = 255;
+    int m_width = 0;
+    int m_lines = 0;
+    Analyses m_analyses = AllAnalyses;
+
+    // blank page detection
+    double m_maximumInkRatio;
+    int m_marginPercent;
+    int m_marginX = 0;
+    int m_marginY = 0;
+    qint64 m_inkPixels = 0;
+    qint64 m_pixelCount = 0;
+    double m_luminanceSum = 0;
+    double m_luminanceSquareSum = 0;
+    bool m_blankPage = false;
+
+    // per channel statistics, the histograms have a bin for every possible value
+    std::array<QVector<quint32>, 3> m_subHistograms;
+    std::array<QList<qint64>, 3> m_histograms;
+    std::array<int, 3> m_minimum;
+    std::array<int, 3> m_maximum;
+    std::array<qint64, 3> m_sum;
+    qint64 m_histogramPixels = 0;
+
+    // page classification
+    qint64 m_colorPixels = 0;
+    qint64 m_midtonePixels = 0;
+    qint64 m_classifiedPixels = 0;
+    PageType m_pageType = ColorPage;
+
+    // content area detection
+    int m_contentLeft = 0;
+    int m_contentRight = -1;
+    int m_contentTop = -1;
+    int m_contentBottom = -1;
+
+    // skew estimation, the dark samples of every row are projected along a set of angles,
+    // the profile with the sharpest peaks belongs to the angle of the text lines
+    QVector<int> m_skewOffsets;
+    QVector<int> m_skewProfiles;
+    int m_skewSamples = 0;
+    int m_skewMaxOffset = 0;
+    qint64 m_skewDarkSamples = 0;
+    double m_skewAngle = 0;
+
+    // the cryptographic hash covers the image data, the perceptual hash compares the average
+    // brightness of a grid of cells with the one of the page
+    bool m_hashing = false;
+    QCryptographicHash m_sha256;
+    QByteArray m_digest;
+    std::array<double, 64> m_hashCells;
+    // the cells of every row of handscanner images, they are assigned to the grid once the height is known
+    QVector<double> m_hashRowCells;
+    int m_hashedRows = 0;
+    quint64 m_perceptualHash = 0;
+};
+
+} // namespace KSaneCore
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(KSaneCore::PageAnalyzer::Analyses)
+
+#endif // KSANE_PAGE_ANALYZER_H
@@ -11,19 +11,192 @@
 #include <QMutexLocker>
 #include <QVariant>
 
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#ifdef Q_OS_LINUX
+#include <pthread.h>
+#include <sched.h>
+#endif
+
 #include <ksanecore_debug.h>
 
+#include "gammaoption.h"
+#include "imageprocessor.h"
+
 namespace KSaneCore
 {
 
 ScanThread::ScanThread(SANE_Handle handle):
     QThread(), m_saneHandle(handle), m_imageBuilder(&m_image, &m_dpi)
 {
-    m_emitProgressUpdateTimer.setSingleShot(false);
-    m_emitProgressUpdateTimer.setInterval(500);
-    connect(&m_emitProgressUpdateTimer, &QTimer::timeout, this, &ScanThread::updateScanProgress);
-    connect(this, &QThread::started, &m_emitProgressUpdateTimer, QOverload<>::of(&QTimer::start));
-    connect(this, &QThread::finished,&m_emitProgressUpdateTimer, &QTimer::stop);
+    m_imageBuilder.setPageAnalyzer(&m_pageAnalyzer);
+    m_pageProcessor.setMaxThreadCount(1);
+    start();
+}
+
+ScanThread::~ScanThread()
+{
+    shutdown();
+    wait();
+}
+
+void ScanThread::startScan()
+{
+    if (m_scanning) {
+        return;
+    }
+    m_scanning = true;
+    // set here, so that a cancel before the thread picks up the command is not lost
+    m_readStatus = ReadOngoing;
+
+    QMutexLocker locker(&m_commandMutex);
+    m_startRequested = true;
+    m_commandCondition.wakeOne();
+}
+
+void ScanThread::shutdown()
+{
+    cancelScan();
+    QMutexLocker locker(&m_commandMutex);
+    m_shutdown = true;
+    m_commandCondition.wakeOne();
+}
+
+bool ScanThread::isScanning() const
+{
+    return m_scanning;
+}
+
+void ScanThread::scanFinishHandled()
+{
+    m_scanning = false;
+}
+
+void ScanThread::setReaderPriority(QThread::Priority priority)
+{
+    QMutexLocker locker(&m_commandMutex);
+    m_readerPriority = priority;
+    m_readerSettingsChanged = true;
+}
+
+void ScanThread::setReaderAffinity(const QList<int> &cpus)
+{
+    QMutexLocker locker(&m_commandMutex);
+    m_readerAffinity = cpus;
+    m_readerSettingsChanged = true;
+}
+
+void ScanThread::setProgressThresholds(int percentStep, int minimumInterval)
+{
+    m_progressStep = qMax(percentStep, 0);
+    m_progressInterval = qMax(minimumInterval, 0);
+}
+
+void ScanThread::setMaximumPendingPages(int pages)
+{
+    QMutexLocker locker(&m_deliveryMutex);
+    m_maxPendingPages = qMax(pages, 0);
+    m_deliveryCondition.wakeAll();
+}
+
+void ScanThread::pageDelivered()
+{
+    QMutexLocker locker(&m_deliveryMutex);
+    m_pendingPages = qMax(0, m_pendingPages - 1);
+    m_deliveryCondition.wakeAll();
+}
+
+void ScanThread::resetStatistics()
+{
+    m_scannedPages = 0;
+    m_blankPages = 0;
+    m_stallCount = 0;
+    m_stallTime = 0;
+}
+
+int ScanThread::scannedPages() const
+{
+    return m_scannedPages;
+}
+
+int ScanThread::blankPages() const
+{
+    return m_blankPages;
+}
+
+int ScanThread::stallCount() const
+{
+    return m_stallCount;
+}
+
+qint64 ScanThread::stallTime() const
+{
+    return m_stallTime;
+}
+
+void ScanThread::waitForDelivery()
+{
+    QMutexLocker locker(&m_deliveryMutex);
+    if (m_maxPendingPages <= 0 || m_pendingPages < m_maxPendingPages) {
+        return;
+    }
+
+    QElapsedTimer stallTimer;
+    stallTimer.start();
+    while (m_maxPendingPages > 0 && m_pendingPages >= m_maxPendingPages && m_multiPageScanning) {
+        m_deliveryCondition.wait(&m_deliveryMutex);
+    }
+    m_stallCount++;
+    m_stallTime += stallTimer.elapsed();
+}
+
+void ScanThread::applyReaderSettings()
+{
+    if (!m_readerSettingsChanged) {
+        return;
+    }
+    m_readerSettingsChanged = false;
+
+#ifdef Q_OS_LINUX
+    // QThread only changes the niceness, the time critical priority uses the realtime
+    // scheduling to keep reading while the system is busy
+    struct sched_param schedParam = {};
+    int policy = SCHED_OTHER;
+    if (m_readerPriority == QThread::TimeCriticalPriority) {
+        policy = SCHED_FIFO;
+        schedParam.sched_priority = sched_get_priority_min(SCHED_FIFO);
+    }
+    const int schedResult = pthread_setschedparam(pthread_self(), policy, &schedParam);
+    if (schedResult != 0) {
+        // usually the process is not allowed to use realtime scheduling
+        qCDebug(KSANECORE_LOG) << "setting the scheduling policy of the scan thread failed:" << strerror(schedResult);
+    }
+    if (policy == SCHED_OTHER || schedResult != 0) {
+        setPriority(m_readerPriority == QThread::InheritPriority ? QThread::NormalPriority : m_readerPriority);
+    }
+
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    for (const int cpu : std::as_const(m_readerAffinity)) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &cpuSet);
+        }
+    }
+    // no valid CPU given, the thread may run on any of them
+    if (CPU_COUNT(&cpuSet) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            CPU_SET(cpu, &cpuSet);
+        }
+    }
+    const int result = pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+    if (result != 0) {
+        qCDebug(KSANECORE_LOG) << "setting the CPU affinity of the scan thread failed:" << result;
+    }
+#else
+    setPriority(m_readerPriority == QThread::InheritPriority ? QThread::NormalPriority : m_readerPriority);
+#endif
 }
 
 void ScanThread::setImageInverted(const QVariant &newValue)
@@ -35,6 +208,89 @@ void ScanThread::setImageInverted(const QVariant &newValue)
     }
 }
 
+void ScanThread::setImageGamma(const QVariant &newValue)
+{
+    const QVariantList values = newValue.toList();
+    std::array<QVector<quint8>, 3> tables8;
+    std::array<QVector<quint16>, 3> tables16;
+
+    // the neutral values leave the image data untouched
+    if (values.size() == 3 && (values.at(0).toInt() != 0 || values.at(1).toInt() != 0 || values.at(2).toInt() != 100)) {
+        const QVector<int> table8 = GammaOption::gammaTable(values.at(0).toInt(), values.at(1).toInt(), values.at(2).toInt(), 256, 0xFF);
+        const QVector<int> table16 = GammaOption::gammaTable(values.at(0).toInt(), values.at(1).toInt(), values.at(2).toInt(), 65536, 0xFFFF);
+        tables8.fill(QVector<quint8>(table8.cbegin(), table8.cend()));
+        tables16.fill(QVector<quint16>(table16.cbegin(), table16.cend()));
+    }
+
+    QMutexLocker locker(&m_imageMutex);
+    m_imageBuilder.setLookUpTables(tables8, tables16);
+}
+
+void ScanThread::setBlankPageDetection(double maximumInkRatio, int marginPercent)
+{
+    QMutexLocker locker(&m_imageMutex);
+    m_pageAnalyzer.setBlankPageDetection(maximumInkRatio, marginPercent);
+}
+
+void ScanThread::setPageHashing(bool enable)
+{
+    QMutexLocker locker(&m_imageMutex);
+    m_pageAnalyzer.setHashing(enable);
+}
+
+void ScanThread::setPageAnalyses(PageAnalyzer::Analyses analyses)
+{
+    QMutexLocker locker(&m_imageMutex);
+    m_pageAnalyzer.setAnalyses(analyses);
+}
+
+void ScanThread::setSkipBlankPages(bool skip)
+{
+    m_skipBlankPages = skip;
+}
+
+void ScanThread::setAutomaticColorReduction(bool enable)
+{
+    m_reduceColors = enable;
+}
+
+void ScanThread::setAutomaticCrop(bool enable)
+{
+    m_cropToContent = enable;
+}
+
+void ScanThread::setAutomaticDeskew(bool enable)
+{
+    m_deskew = enable;
+}
+
+void ScanThread::setScanRegions(const QList<QRect> &regions)
+{
+    QMutexLocker locker(&m_imageMutex);
+    m_scanRegions = regions;
+}
+
+void ScanThread::setReductionFactors(const QList<int> &factors)
+{
+    QMutexLocker locker(&m_imageMutex);
+    m_imageBuilder.setReductionFactors(factors);
+}
+
+QList<QImage> ScanThread::reducedImages()
+{
+    return m_imageBuilder.reducedImages();
+}
+
+const ImageRegionView &ScanThread::regionView() const
+{
+    return m_regionView;
+}
+
+QVariantMap ScanThread::pageMetadata() const
+{
+    return m_pageMetadata;
+}
+
 void ScanThread::setImageResolution(const QVariant &newValue)
 {
     bool ok;
@@ -69,15 +325,95 @@ void ScanThread::unlockScanImage()
     m_imageMutex.unlock();
 }
 
+void ScanThread::setMultiPageScanning(bool multiPage)
+{
+    m_multiPageScanning = multiPage;
+}
+
 void ScanThread::cancelScan()
 {
+    // no further sheet must be started after this point
+    m_multiPageScanning = false;
     m_readStatus = ReadCancel;
+
+    QMutexLocker locker(&m_deliveryMutex);
+    m_deliveryCondition.wakeAll();
 }
 
 void ScanThread::run()
+{
+    QMutexLocker locker(&m_commandMutex);
+    while (true) {
+        while (!m_startRequested && !m_shutdown) {
+            m_commandCondition.wait(&m_commandMutex);
+        }
+        if (m_shutdown) {
+            return;
+        }
+        m_startRequested = false;
+        applyReaderSettings();
+        locker.unlock();
+
+        scanPages();
+        deskewLastPage();
+        // the pages handed over are delivered before the scan finishes
+        m_pageProcessor.waitForDone();
+
+        // the scan counts as running until scanFinishHandled() is called
+        Q_EMIT scanFinished();
+        locker.relock();
+    }
+}
+
+void ScanThread::scanPages()
+{
+    {
+        // pages which were not handed back, e.g. after a cancelled delivery, must not stall this scan
+        QMutexLocker locker(&m_deliveryMutex);
+        m_pendingPages = 0;
+    }
+    if (m_readStatus == ReadCancel) {
+        m_saneStatus = SANE_STATUS_GOOD;
+        return;
+    }
+    scanPage();
+    while (m_readStatus == ReadReady && m_multiPageScanning) {
+        m_scannedPages++;
+        // blank pages are neither copied nor delivered
+        if (!skipPage()) {
+            // hand the page over and let the feeder continue while it is processed
+            QImage page;
+            {
+                QMutexLocker locker(&m_imageMutex);
+                page.swap(m_image);
+            }
+            {
+                QMutexLocker locker(&m_deliveryMutex);
+                m_pendingPages++;
+            }
+            deliverPage(page);
+            // no sheet is fed and no data is read until the consumer catches up
+            waitForDelivery();
+        }
+
+        m_readStatus = ReadOngoing;
+        // cancelScan() might have been called after the check above
+        if (!m_multiPageScanning) {
+            // finish like a scan cancelled while reading
+            m_saneStatus = SANE_STATUS_GOOD;
+            m_readStatus = ReadCancel;
+            return;
+        }
+        scanPage();
+    }
+    if (m_readStatus == ReadReady) {
+        m_scannedPages++;
+    }
+}
+
+void ScanThread::scanPage()
 {
     m_dataSize = 0;
-    m_readStatus = ReadOngoing;
     m_announceFirstRead = true;
 
     // Start the scanning with sane_start
@@ -114,13 +450,144 @@ void ScanThread::run()
         m_dataSize = m_frameSize;
     }
 
+    m_regionView.clear();
     m_imageBuilder.start(m_params);
+    // the image of handscanners grows while it is received, its tiles are available at the end
+    if (m_params.lines > 0) {
+        m_regionView.start(m_image);
+    }
+    {
+        QMutexLocker locker(&m_imageMutex);
+        // the regions are delivered in the order of their last rows
+        m_pendingRegions.clear();
+        for (int i = 0; i < m_scanRegions.size(); i++) {
+            m_pendingRegions.append(i);
+        }
+        std::stable_sort(m_pendingRegions.begin(), m_pendingRegions.end(), [this](int a, int b) {
+            return m_scanRegions.at(a).bottom() < m_scanRegions.at(b).bottom();
+        });
+    }
     m_frameRead = 0;
     m_frame_t_count = 0;
 
     while (m_readStatus == ReadOngoing) {
         readData();
     }
+    if (m_readStatus == ReadReady) {
+        finishPage();
+    }
+}
+
+void ScanThread::finishPage()
+{
+    QMutexLocker locker(&m_imageMutex);
+    m_pageSkewAngle = 0;
+    m_imageBuilder.finish();
+    // the image might have been cropped to the received rows
+    m_regionView.replaceImage(m_image);
+    publishTiles(m_image.height());
+    m_pageMetadata = m_pageAnalyzer.metadata();
+    if (!m_imageBuilder.reducedImages().isEmpty()) {
+        m_pageMetadata[QStringLiteral("reducedImages")] = QVariant::fromValue(m_imageBuilder.reducedImages());
+    }
+    if (m_pageAnalyzer.isBlankPage()) {
+        m_blankPages++;
+    }
+
+    // only the regions are delivered, the full image is not processed
+    if (!m_scanRegions.isEmpty()) {
+        deliverRegions(std::numeric_limits<int>::max());
+        return;
+    }
+
+    // the skew has been estimated with the rows, the page is straightened after it has been handed over,
+    // angles below the resolution of the estimation are not corrected
+    if (m_deskew && qAbs(m_pageAnalyzer.skewAngle()) > 0.1) {
+        m_pageSkewAngle = m_pageAnalyzer.skewAngle();
+    }
+
+    // the cropped image shares the data with the full image
+    if (m_cropToContent && m_pageAnalyzer.contentArea().isValid()) {
+        m_image = ImageProcessor::subImage(m_image, m_pageAnalyzer.contentArea());
+    }
+
+    if (!m_reduceColors) {
+        return;
+    }
+    // the image is converted to the smallest format which keeps its content
+    const bool colorImage = m_image.format() == QImage::Format_RGB32 || m_image.format() == QImage::Format_RGBX64;
+    switch (m_pageAnalyzer.pageType()) {
+    case PageAnalyzer::LineartPage:
+        if (m_image.format() != QImage::Format_Mono) {
+            m_image = ImageProcessor::convertToMono(m_image);
+        }
+        break;
+    case PageAnalyzer::GrayPage:
+        if (colorImage) {
+            m_image = ImageProcessor::convertToGrayscale(m_image);
+        }
+        break;
+    case PageAnalyzer::ColorPage:
+        break;
+    }
+}
+
+void ScanThread::deliverPage(const QImage &page)
+{
+    m_pageProcessor.start([this, page, metadata = m_pageMetadata, skewAngle = m_pageSkewAngle]() {
+        if (skewAngle == 0) {
+            Q_EMIT pageScanned(page, metadata);
+            return;
+        }
+        Q_EMIT pageScanned(ImageProcessor::deskew(page, skewAngle), metadata);
+    });
+}
+
+void ScanThread::deskewLastPage()
+{
+    // the last page stays the scan image, it is only locked to be replaced
+    if (m_readStatus != ReadReady || m_pageSkewAngle == 0 || skipPage()) {
+        return;
+    }
+    QImage page;
+    {
+        QMutexLocker locker(&m_imageMutex);
+        page = m_image;
+    }
+    m_pageProcessor.start([this, page, skewAngle = m_pageSkewAngle]() {
+        const QImage straightened = ImageProcessor::deskew(page, skewAngle);
+        QMutexLocker locker(&m_imageMutex);
+        m_image = straightened;
+    });
+    m_pageSkewAngle = 0;
+}
+
+bool ScanThread::skipPage() const
+{
+    return m_skipBlankPages && m_pageAnalyzer.isBlankPage();
+}
+
+void ScanThread::deliverRegions(int completedRows)
+{
+    while (!m_pendingRegions.isEmpty() && m_scanRegions.at(m_pendingRegions.first()).bottom() < completedRows) {
+        const int region = m_pendingRegions.takeFirst();
+        const QRect &area = m_scanRegions.at(region);
+        // the rows of the region are not written again, the region shares them with the scanned image
+        if (area.intersects(m_image.rect())) {
+            Q_EMIT regionScanned(region, ImageProcessor::subImage(m_image, area));
+        } else {
+            Q_EMIT regionScanned(region, QImage());
+        }
+    }
+}
+
+void ScanThread::publishTiles(int completedRows)
+{
+    const int firstTileRow = m_regionView.completedTileRows();
+    m_regionView.setCompletedRows(completedRows);
+    for (int tileRow = firstTileRow; tileRow < m_regionView.completedTileRows(); tileRow++) {
+        Q_EMIT tilesCompleted(tileRow, m_regionView.columns());
+    }
 }
 
 void ScanThread::updateScanProgress()
@@ -130,16 +597,27 @@ void ScanThread::updateScanProgress()
         return;
     }
 
-    int bytesRead;
+    qint64 bytesRead;
 
     if (m_frameSize < m_dataSize) {
-        bytesRead = m_frameRead + (m_frameSize * m_frame_t_count);
+        bytesRead = m_frameRead + (static_cast<qint64>(m_frameSize) * m_frame_t_count);
     } else {
         bytesRead = m_frameRead;
     }
 
-    if (bytesRead > 0) {
-        Q_EMIT scanProgressUpdated(static_cast<int>((static_cast<float>(bytesRead) * 100.0) / m_dataSize));
+    const int progress = static_cast<int>(bytesRead * 100 / m_dataSize);
+    const qint64 elapsed = m_progressClock.elapsed();
+    if (progress - m_lastProgress < m_progressStep || elapsed - m_lastProgressTime < m_progressInterval) {
+        return;
+    }
+    m_lastProgress = progress;
+    m_lastProgressTime = elapsed;
+    Q_EMIT scanProgressUpdated(progress);
+
+    if (elapsed > 0) {
+        const qint64 bytesPerSecond = bytesRead * 1000 / elapsed;
+        const int remainingTime = bytesPerSecond > 0 ? static_cast<int>((m_dataSize - bytesRead) * 1000 / bytesPerSecond) : -1;
+        Q_EMIT scanRateUpdated(bytesPerSecond, remainingTime);
     }
 }
 
@@ -151,6 +629,10 @@ void ScanThread::readData()
     if (readBytes > 0 && m_announceFirstRead) {
         Q_EMIT scanProgressUpdated(0);
         m_announceFirstRead = false;
+        // the transfer rate is measured from the first data on
+        m_progressClock.start();
+        m_lastProgress = 0;
+        m_lastProgressTime = 0;
     }
 
     switch (m_saneStatus) {
@@ -234,6 +716,10 @@ void ScanThread::copyToScanData(int readBytes)
     QMutexLocker locker(&m_imageMutex);
     if (m_imageBuilder.copyToImage(m_readData, readBytes)) {
         m_frameRead += readBytes;
+        deliverRegions(m_imageBuilder.completedRows());
+        publishTiles(m_imageBuilder.completedRows());
+        locker.unlock();
+        updateScanProgress();
     } else {
         m_readStatus = ReadError;
     }
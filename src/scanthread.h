@@ -10,6 +10,8 @@
 #define KSANE_SCAN_THREAD_H
 
 #include "imagebuilder.h"
+#include "pageanalyzer.h"
+#include "imageregionview.h"
 
 // Sane includes
 extern "C"
@@ -21,8 +23,15 @@ extern "C"
 #include <QThread>
 #include <QMutex>
 #include <QByteArray>
+#include <QElapsedTimer>
 #include <QImage>
-#include <QTimer>
+#include <QList>
+#include <QRect>
+#include <QThreadPool>
+#include <QVariantMap>
+#include <QWaitCondition>
+
+#include <atomic>
 
 #define SCAN_READ_CHUNK_SIZE 100000
 
@@ -41,9 +50,39 @@ public:
     };
 
     explicit ScanThread(SANE_Handle handle);
+    ~ScanThread() override;
     void run() override;
+    void startScan();
+    void shutdown();
+    bool isScanning() const;
+    void scanFinishHandled();
+    void setReaderPriority(QThread::Priority priority);
+    void setReaderAffinity(const QList<int> &cpus);
+    void setProgressThresholds(int percentStep, int minimumInterval);
+    void setMaximumPendingPages(int pages);
+    void setBlankPageDetection(double maximumInkRatio, int marginPercent);
+    void setSkipBlankPages(bool skip);
+    void setAutomaticColorReduction(bool enable);
+    void setAutomaticCrop(bool enable);
+    void setAutomaticDeskew(bool enable);
+    void setPageHashing(bool enable);
+    void setPageAnalyses(PageAnalyzer::Analyses analyses);
+    void setScanRegions(const QList<QRect> &regions);
+    void setReductionFactors(const QList<int> &factors);
+    QList<QImage> reducedImages();
+    const ImageRegionView &regionView() const;
+    QVariantMap pageMetadata() const;
+    bool skipPage() const;
+    void pageDelivered();
+    void resetStatistics();
+    int scannedPages() const;
+    int stallCount() const;
+    int blankPages() const;
+    qint64 stallTime() const;
     void setImageInverted(const QVariant &newValue);
+    void setImageGamma(const QVariant &newValue);
     void setImageResolution(const QVariant &newValue);
+    void setMultiPageScanning(bool multiPage);
     void cancelScan();
 
     ReadStatus frameStatus();
@@ -56,8 +95,22 @@ public:
 Q_SIGNALS:
 
     void scanProgressUpdated(int progress);
+    void scanRateUpdated(qint64 bytesPerSecond, int remainingTime);
+    void pageScanned(const QImage &image, const QVariantMap &metadata);
+    void regionScanned(int region, const QImage &image);
+    void tilesCompleted(int tileRow, int columns);
+    void scanFinished();
 
 private:
+    void applyReaderSettings();
+    void scanPages();
+    void scanPage();
+    void waitForDelivery();
+    void finishPage();
+    void deliverPage(const QImage &page);
+    void deskewLastPage();
+    void deliverRegions(int completedRows);
+    void publishTiles(int completedRows);
     void readData();
     void updateScanProgress();
     void copyToScanData(int readBytes);
@@ -74,11 +127,57 @@ private:
     ReadStatus      m_readStatus = ReadReady;
     bool            m_announceFirstRead = true;
     bool            m_invertColors = false;
+    // the next sheet is scanned right after the current one has been read
+    std::atomic<bool> m_multiPageScanning = false;
     ImageBuilder    m_imageBuilder;
+    PageAnalyzer    m_pageAnalyzer;
+    QVariantMap     m_pageMetadata;
+    std::atomic<bool> m_skipBlankPages = false;
+    std::atomic<bool> m_reduceColors = false;
+    std::atomic<bool> m_cropToContent = false;
+    std::atomic<bool> m_deskew = false;
+    // the angle the finished page is straightened by, 0 if it is not
+    double          m_pageSkewAngle = 0;
     QImage          m_image;
     QMutex          m_imageMutex;
 
-    QTimer          m_emitProgressUpdateTimer;
+    // the regions in pixels of the scanned image which are delivered as soon as their last row is complete
+    QList<QRect>    m_scanRegions;
+    QList<int>      m_pendingRegions;
+    // the completed rows can be viewed without locking the image
+    ImageRegionView m_regionView;
+
+    // the reader reports the progress when both thresholds are exceeded
+    std::atomic<int> m_progressStep = 1;
+    std::atomic<int> m_progressInterval = 100;
+    int             m_lastProgress = 0;
+    qint64          m_lastProgressTime = 0;
+    QElapsedTimer   m_progressClock;
+
+    // the reader pauses before the next sheet while too many pages are not yet delivered
+    QMutex          m_deliveryMutex;
+    QWaitCondition  m_deliveryCondition;
+    int             m_pendingPages = 0;
+    std::atomic<int> m_maxPendingPages = 0;
+    std::atomic<int> m_scannedPages = 0;
+    std::atomic<int> m_stallCount = 0;
+    std::atomic<int> m_blankPages = 0;
+    std::atomic<qint64> m_stallTime = 0;
+
+    // the thread lives as long as the device is open and waits for start commands
+    QMutex          m_commandMutex;
+    QWaitCondition  m_commandCondition;
+    bool            m_startRequested = false;
+    bool            m_shutdown = false;
+    // set until the receiver of scanFinished() handled it
+    std::atomic<bool> m_scanning = false;
+    QThread::Priority m_readerPriority = QThread::InheritPriority;
+    QList<int>      m_readerAffinity;
+    bool            m_readerSettingsChanged = false;
+
+    // straightens the finished pages in the order they were scanned while the reader continues,
+    // it is destroyed first, so that its tasks do not outlive the image
+    QThreadPool     m_pageProcessor;
 };
 
 } // namespace KSaneCore